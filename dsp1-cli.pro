@@ -0,0 +1,22 @@
+#-------------------------------------------------
+#
+# Headless batch runner for the DSP1 pipeline,
+# links the signal core and the figure renderer without QtWidgets/QCustomPlot
+#
+#-------------------------------------------------
+
+QT       = core
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = dsp1-cli
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+VPATH += src
+
+SOURCES += cli.cpp
+
+include(dsp1_core.pri)
+include(dsp1_plot.pri)
@@ -5,7 +5,7 @@
 #-------------------------------------------------
 
 QT       += core gui
-CONFIG += c++14
+CONFIG += c++17
 RC_FILE = ./icons/dsp1.rc
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets printsupport
@@ -19,6 +19,9 @@ TEMPLATE = app
 # deprecated API in order to know how to port your code away from it.
 DEFINES += QT_DEPRECATED_WARNINGS
 
+# Let QCustomPlot sample large graphs on all cores (QtConcurrent comes with dsp1_core.pri)
+DEFINES += QCUSTOMPLOT_USE_CONCURRENT
+
 # You can also make your code fail to compile if you use deprecated APIs.
 # In order to do so, uncomment the following line.
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
@@ -35,11 +38,12 @@ INCLUDEPATH += headers \
 SOURCES += main.cpp\
     mainwindow.cpp \
     qcustomplot.cpp \
-    dsp1_signal.cpp
+    probabilitymodel.cpp
 
 HEADERS  += mainwindow.h \
     qcustomplot.h \
-    dsp1_signal.h \
-    constants.h
+    probabilitymodel.h
 
 FORMS    += mainwindow.ui
+
+include(dsp1_core.pri)
@@ -0,0 +1,43 @@
+# Signal processing core shared by the GUI (dsp1.pro) and the
+# command-line batch runner (dsp1-cli.pro). Needs QtCore and QtConcurrent only.
+
+QT += concurrent
+
+VPATH += $$PWD/src \
+    $$PWD/headers
+
+INCLUDEPATH += $$PWD/headers
+
+SOURCES += dsp1_signal.cpp \
+    fft.cpp \
+    streamconvolver.cpp \
+    signalgenerators.cpp \
+    histogram.cpp \
+    batchhistogram.cpp \
+    entropy.cpp \
+    statistics.cpp \
+    signalpipeline.cpp \
+    signalio.cpp \
+    signalfile.cpp \
+    chunkedsignal.cpp \
+    parametersweep.cpp \
+    montecarlo.cpp
+
+HEADERS += dsp1_signal.h \
+    constants.h \
+    fft.h \
+    streamconvolver.h \
+    signalgenerators.h \
+    histogram.h \
+    batchhistogram.h \
+    entropy.h \
+    statistics.h \
+    samples.h \
+    parallel.h \
+    randomstream.h \
+    signalpipeline.h \
+    signalio.h \
+    signalfile.h \
+    chunkedsignal.h \
+    parametersweep.h \
+    montecarlo.h
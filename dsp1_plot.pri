@@ -0,0 +1,8 @@
+# Widget-free figure rendering on top of the signal core, used by the command-line
+# batch runner (dsp1-cli.pro). Needs QtGui but no QtWidgets.
+
+QT += gui
+
+SOURCES += plotrenderer.cpp
+
+HEADERS += plotrenderer.h
@@ -0,0 +1,36 @@
+#ifndef BATCHHISTOGRAM_H
+#define BATCHHISTOGRAM_H
+
+#include <QVector>
+#include <QString>
+#include "samples.h"
+
+// Histograms and entropies of many signals, laid out as struct of arrays: every field
+// holds one entry per signal, and the probabilities of signal i are the row
+// probability[i*stride, i*stride + bins[i]), zero-padded up to stride.
+// Every histogram matches Signal::setHistogram for the same samples and bins value.
+struct HistogramBatch {
+    int signalCount;
+    int stride;
+    QVector<double> min;
+    QVector<double> max;
+    QVector<double> binWidth;
+    QVector<double> firstKey;
+    QVector<int> bins;
+    QVector<double> probability;
+    QVector<double> entropy;
+
+    const double* row(int signal) const;
+    // Bin positions of signal, same as Signal::getHistogramXAxis
+    QVector<double> xAxis(int signal) const;
+};
+
+// One histogram per signal, signals are binned in parallel. Fails with an empty batch
+// (signalCount 0) if the probability rows would not fit into one QVector.
+HistogramBatch batchHistograms(const QVector<SampleView>& signalsToBin, double bins, QString* error = 0);
+
+// Same for signalCount signals of length samples each, stored row after row in samples
+HistogramBatch batchHistograms(const double* samples, int signalCount, int length, double bins,
+                               QString* error = 0);
+
+#endif // BATCHHISTOGRAM_H
@@ -0,0 +1,78 @@
+#ifndef CHUNKEDSIGNAL_H
+#define CHUNKEDSIGNAL_H
+
+#include <QVector>
+#include <QString>
+#include <memory>
+#include "samples.h"
+#include "statistics.h"
+#include "constants.h"
+
+struct ChunkedSignalFile;
+
+// Range of samples of a ChunkedSignal, mapped into memory while any copy of the page exists
+class SignalPage
+{
+    public:
+        SignalPage();
+        SampleView getView() const;
+        qint64 getFirst() const;
+    private:
+        friend class ChunkedSignal;
+
+        SampleView view;
+        qint64 first;
+        std::shared_ptr<const void> storage;
+};
+
+// Signal file that may be far larger than memory. Samples are only touched one page
+// at a time: pages are mapped when an operation reaches them and unmapped right after,
+// so memory use depends on the page size and the number of workers, not on the file size.
+class ChunkedSignal
+{
+    public:
+        explicit ChunkedSignal(int pageSize = chunkedSignalPageSize);
+        bool open(const QString& fileName, QString* error = 0);
+        // Streams the sample-wise sum of inputs (cut to the shortest one) into a new signal file
+        static bool writeSum(const QVector<ChunkedSignal>& inputs, const QString& fileName,
+                             SampleFormat format = Float64Format, QString* error = 0);
+        // Streams the linear convolution of input with kernel (input.getSize() + kernel.size() - 1
+        // samples, in natural order unlike Signal::setByConvolution) into a new signal file.
+        // Overlap-add keeps memory at one page plus a few kernel lengths, whatever the input size.
+        static bool writeConvolution(const ChunkedSignal& input, const QVector<double>& kernel,
+                                     const QString& fileName, SampleFormat format = Float64Format,
+                                     QString* error = 0);
+        // Pages past the end are empty. A page that cannot be mapped or read is empty too,
+        // and then error tells the two apart.
+        SignalPage getPage(qint64 index, QString* error = 0) const;
+        SignalPage getRange(qint64 first, int count, QString* error = 0) const;
+        qint64 getPageCount() const;
+        int getPageSize() const;
+        qint64 getSize() const;
+        SampleFormat getFormat() const;
+        // One parallel pass over all pages, cached like Signal::getStatistics.
+        // Fails (and caches nothing) if a page cannot be read.
+        bool computeStatistics(QString* error = 0) const;
+        // All zero if the statistics cannot be computed, the getters below return NaN then;
+        // error receives the reason
+        const SignalStatistics& getStatistics(QString* error = 0) const;
+        double getSum(QString* error = 0) const;
+        double getMin(QString* error = 0) const;
+        double getMax(QString* error = 0) const;
+        bool setHistogram(double bins, QString* error = 0);
+        const QVector<double>& getHistogramXAxis() const;
+        const QVector<double>& getHistogramYAxis() const;
+        double getEntropy() const;
+    private:
+        template<typename Task>
+        bool forEachPage(Task task, QString* error) const;
+
+        std::shared_ptr<ChunkedSignalFile> file;
+        int pageSize;
+        QVector<double> histogramXAxis;
+        QVector<double> histogramYAxis;
+        mutable SignalStatistics statistics;
+        mutable bool statisticsValid;
+};
+
+#endif // CHUNKEDSIGNAL_H
@@ -16,15 +16,31 @@ const double signalDefaultMu = 50;
 const int noiseDefaultCount = signalDefaultCount;
 const double noiseDefaultMean = 5;
 const double noiseDefaultSD = 2;
+const quint64 noiseDefaultSeed = 0;
 
 // Histogram default parameters
 const int histogramDefaultBins = 100;
 
+// Inputs shorter than this are convolved directly instead of through FFT
+const int convolutionFftThreshold = 64;
+
+// Upper bound of samples kept by the pipeline cache
+const int pipelineCacheSamples = 32 * 1024 * 1024;
+
+// Samples per page of a ChunkedSignal
+const int chunkedSignalPageSize = 1 << 20;
+
+// Size of figures exported without the plot widget
+const int plotExportWidth = 800;
+const int plotExportHeight = 600;
+
 // Signals labels
 const QString signalLabel = "Signal";
 const QString noiseLabel = "Noise";
 const QString sumLabel = "Sum";
 const QString convolutionLabel = "Convolution";
+// signal whose histogram is the convolution of the signal and noise histograms
+const QString histogramConvolutionLabel = "HistogramConvolution";
 
 // Tab titles
 const QString tabSignalTitle = "Signal";
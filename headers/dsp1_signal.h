@@ -2,37 +2,87 @@
 #define DSP1_SIGNAL_H
 
 #include <QVector>
+#include <QString>
+#include <memory>
+#include "signalgenerators.h"
+#include "statistics.h"
+#include "samples.h"
+#include "entropy.h"
+
+// Non-owning view of contiguous samples, valid while the viewed signal is unchanged
+struct SampleSpan {
+    const double* data;
+    int size;
+};
+
+class MappedSignalFile;
 
 class Signal
 {
     public:
         Signal();
         void setBySum(const std::initializer_list<Signal> signalsToAdd);
+        void setBySum(const QVector<SampleSpan>& signalsToAdd);
+        void setBySum(const QVector<SampleView>& signalsToAdd);
         void setByConvolution(const Signal& signalA, const Signal& signalB);
         void setByFormula(int count, double step, double a, double sigma, double mu);
-        void setByNoise(int count, double mean, double sd, double lowBoundary, double highBoundary);
+        void setByNoise(int count, double mean, double sd, double lowBoundary, double highBoundary,
+                        NoiseSampling sampling = TruncatedSampling);
+        // Maps a binary signal file (see signalfile.h) instead of reading it into memory,
+        // the signal takes the sample format of the file
+        bool setByFile(const QString& fileName, QString* error = 0);
+        // Samples computed by the setBy* functions are stored in this format,
+        // existing samples are converted (int16 values are rounded and saturated)
+        void setFormat(SampleFormat format);
+        SampleFormat getFormat() const;
         void setHistogram(double bins);
+        void setSeed(quint64 seed);
+        quint64 getSeed() const;
+        // Mapped and non-float64 signals are widened into a QVector on the first call,
+        // prefer getView() or getSamples()
         const QVector<double>& getSignal() const;
+        // Non-float64 signals are widened like getSignal()
+        SampleSpan getSamples() const;
+        SampleView getView() const;
         const QVector<double>& getHistogramXAxis() const;
         const QVector<double>& getHistogramYAxis() const;
         void convolveHistograms(Signal &anotherSignal, int bins);
         const QVector<double>& getProbability() const;
-        double getEntropy() const;
+        // Estimators other than the plug-in one need the histogram of setHistogram,
+        // after convolveHistograms they fall back to the plug-in estimate
+        double getEntropy(EntropyEstimator estimator = PlugInEstimator) const;
         double getMin() const;
         double getMax() const;
+        const SignalStatistics& getStatistics() const;
         size_t getSize() const;
     private:
-        QVector<double> convolve(const QVector<double>& dataA, const QVector<double>& dataB);
-        double hround(double value, double bin);
+        QVector<double> convolve(const SampleView& dataA, const SampleView& dataB);
+        template<typename T> QVector<T>& storage();
+        void releaseSamples();
+        void narrowSamples();
         void setMinMax();
 
+        SampleFormat format;
+        // only the vector of format holds samples, the others stay empty
         QVector<double> signal;
+        QVector<float> signalFloat32;
+        QVector<qint16> signalInt16;
+        // samples of setByFile, shared between copies; the vectors stay empty while it is set
+        std::shared_ptr<const MappedSignalFile> file;
+        mutable QVector<double> widened;
         QVector<double> probability;
         QVector<double> histogramXAxis;
         QVector<double> histogramYAxis;
+        // samples per bin and bin width of the last setHistogram, empty after convolveHistograms
+        QVector<qint64> histogramCountsPerBin;
+        double histogramBinWidth;
         double min;
         double max;
         double histogramBins;
+        quint64 seed;
+        // filled on demand by the fused statistics pass, reset whenever the samples change
+        mutable SignalStatistics statistics;
+        mutable bool statisticsValid;
 };
 
 #endif // DSP1_SIGNAL_H
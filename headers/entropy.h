@@ -0,0 +1,32 @@
+#ifndef ENTROPY_H
+#define ENTROPY_H
+
+#include <QVector>
+#include "samples.h"
+
+// How Signal::getEntropy estimates the entropy of the samples behind a histogram.
+// PlugInEstimator is -sum(p*log2(p)) of the histogram, biased low for few samples per bin.
+// MillerMadowEstimator and JackknifeEstimator correct that bias from the same counts.
+// KozachenkoLeonenkoEstimator (k-nearest-neighbour distances) and KernelDensityEstimator
+// (FFT-binned Gaussian KDE) estimate the differential entropy h of the samples instead and
+// report h - log2(binWidth), the entropy of the histogram they predict, so all estimators
+// can be compared with each other.
+enum EntropyEstimator {
+    PlugInEstimator,
+    MillerMadowEstimator,
+    JackknifeEstimator,
+    KozachenkoLeonenkoEstimator,
+    KernelDensityEstimator
+};
+
+// Entropies in bits of the distribution behind histogram counts
+double plugInEntropy(const QVector<qint64>& counts);
+double millerMadowEntropy(const QVector<qint64>& counts);
+double jackknifeEntropy(const QVector<qint64>& counts);
+
+// Differential entropies in bits of the density behind samples
+double kozachenkoLeonenkoEntropy(const SampleView& samples, int k = 1);
+// bandwidth 0 picks Silverman's rule of thumb
+double kernelDensityEntropy(const SampleView& samples, double bandwidth = 0);
+
+#endif // ENTROPY_H
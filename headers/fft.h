@@ -0,0 +1,23 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <QVector>
+#include <complex>
+#include "samples.h"
+
+typedef std::complex<double> Complex;
+
+// Smallest power of two that is not less than minLength
+int fftLength(int minLength);
+
+// In-place iterative radix-2 FFT, data size must be a power of two.
+// The inverse transform is scaled by 1/N.
+void fft(QVector<Complex>& data, bool inverse = false);
+
+// Full linear convolution (sizeA + sizeB - 1 samples) of two real sequences
+QVector<double> fftConvolve(const double* dataA, int sizeA, const double* dataB, int sizeB);
+
+// Same for samples in any storage format, they are widened while being packed into the transform
+QVector<double> fftConvolve(const SampleView& dataA, const SampleView& dataB);
+
+#endif // FFT_H
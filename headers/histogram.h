@@ -0,0 +1,48 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <QVector>
+#include <math.h>
+
+// Bins are aligned to multiples of binWidth, bin i covers
+// [(firstKey + i)*binWidth, (firstKey + i + 1)*binWidth)
+struct HistogramLayout {
+    double binWidth;
+    double firstKey;
+    int size;
+};
+
+HistogramLayout histogramLayout(double min, double max, double bins, long long samples);
+
+// Number of samples per bin, large inputs are counted by several threads.
+// Instantiated for double, float and qint16 samples.
+template<typename T>
+QVector<qint64> histogramCounts(const T* data, long long size, const HistogramLayout& layout);
+
+// Adds the counts of data[0, size) to counts[0, layout.size)
+template<typename T>
+void histogramAccumulate(const T* data, long long size, const HistogramLayout& layout, qint64* counts);
+
+// Large int16 inputs are counted per distinct value first
+template<>
+void histogramAccumulate(const qint16* data, long long size, const HistogramLayout& layout, qint64* counts);
+
+// Shannon entropy in bits of a histogram given as probabilities
+double histogramEntropy(const QVector<double>& probability);
+double histogramEntropy(const double* probability, int size);
+
+// Bin index of value, values outside of the layout are clamped to the outer bins
+inline int histogramIndex(double value, const HistogramLayout& layout) {
+    double index = floor(value / layout.binWidth) - layout.firstKey;
+
+    if (!(index > 0)) {
+        return 0;
+    }
+    if (index >= layout.size - 1) {
+        return layout.size - 1;
+    }
+
+    return static_cast<int>(index);
+}
+
+#endif // HISTOGRAM_H
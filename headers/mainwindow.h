@@ -3,6 +3,8 @@
 
 #include <QMainWindow>
 #include "dsp1_signal.h"
+#include "signalpipeline.h"
+#include "probabilitymodel.h"
 #include "qcustomplot.h"
 
 namespace Ui {
@@ -36,23 +38,36 @@ private slots:
 
     void on_buttonSaveSumProb_clicked();
 
+    void onPipelineProgress(int percent, const QString& stage);
+
+    void onPipelineFinished(const SignalMap& results);
+
+    void onPipelineCanceled();
+
 private:
     Ui::MainWindow *ui;
     QCPBars* bars;
-    QMap<QString, Signal> data;
-
+    QProgressBar* progressBar;
+    SignalPipeline* pipeline;
+    ProbabilityTableModel* signalProbabilityModel;
+    ProbabilityTableModel* noiseProbabilityModel;
+    ProbabilityTableModel* sumProbabilityModel;
+    PipelineParameters parameters;
+    SignalMap data;
+
+    bool computing;
     bool firstStart;
 
+    void showResults();
+    void setRunning(bool running);
+
     void plotGraph(const Signal& signal) const;
     void plotGraph(const QVector<double>& xAxis, const QVector<double>& yAxis) const;
     void plotHistogram(const Signal& signal);
     void plotBars(const QVector<double>& xAxis, const QVector<double>& yAxis);
 
-    void createTable(QTableWidget* table, int numOfRows, int numOfCols, const QVector<QString>& horizHeaders);
-    template<typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value, T>::type>
-    void fillTable(QTableWidget* table, const std::initializer_list<QVector<T>> colsData);
-    void saveTableToFile(QString fileName, QTableWidget* table);
-    QStringList tableToQStringList(QTableWidget* table);
+    void setupTable(QTableView* table, QAbstractItemModel* model);
+    void saveProbabilityToFile(QString fileName, const Signal& signal);
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,52 @@
+#ifndef MONTECARLO_H
+#define MONTECARLO_H
+
+#include <QVector>
+#include <QAtomicInt>
+#include "signalpipeline.h"
+
+struct MonteCarloSettings {
+    int maxRealizations;
+    // the interval is not trusted before this many realizations
+    int minRealizations;
+    // realizations run between two convergence checks; a fixed value keeps the
+    // stopping point, and so the result, independent of the number of cores
+    int roundSize;
+    double confidence;
+    // stop once both interval half-widths are at most this many bits, 0 runs every realization
+    double tolerance;
+};
+
+// Mean and sample variance of the entropies of all realizations and the
+// normal-approximation confidence interval [low, high] of the mean
+struct EntropyEstimate {
+    double mean;
+    double variance;
+    double low;
+    double high;
+};
+
+struct MonteCarloResult {
+    int realizations;
+    bool converged;
+    EntropyEstimate noise;
+    EntropyEstimate sum;
+    QVector<double> noiseEntropies;
+    QVector<double> sumEntropies;
+};
+
+// Repeats noise -> sum -> histogram -> entropy of the pipeline with independent seeds
+// derived from parameters.noiseSeed, a round of realizations at a time in parallel
+class MonteCarloEntropy
+{
+    public:
+        static MonteCarloSettings defaultSettings();
+        // Realizations skipped after cancellation are not part of the result. Fails if a
+        // round cannot be binned (see batchHistograms), result then holds the earlier rounds.
+        static bool run(const PipelineParameters& parameters, const MonteCarloSettings& settings,
+                        MonteCarloResult& result, const QAtomicInt* canceled = 0, QString* error = 0);
+        static EntropyEstimate estimate(const QVector<double>& entropies, double confidence);
+        static bool writeResults(const MonteCarloResult& result, const QString& fileName);
+};
+
+#endif // MONTECARLO_H
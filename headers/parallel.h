@@ -0,0 +1,178 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+inline int parallelWorkerCount() {
+    static const int count = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    return count;
+}
+
+// True while the current thread runs a task of parallelChunks or parallelForStealing.
+// All workers are busy then, so kernels called from such a task stay on its thread
+// instead of starting workers * workers threads.
+inline bool& parallelTaskActive() {
+    static thread_local bool active = false;
+    return active;
+}
+
+// Marks the current thread as running a parallel task for its lifetime (if active)
+class ParallelTaskScope
+{
+    public:
+        explicit ParallelTaskScope(bool active = true) : previous(parallelTaskActive()) {
+            parallelTaskActive() = previous || active;
+        }
+        ~ParallelTaskScope() {
+            parallelTaskActive() = previous;
+        }
+    private:
+        bool previous;
+};
+
+// Number of chunks worth splitting count items into, so that every chunk
+// holds at least minChunkSize items and no more chunks than workers exist.
+// Always 1 inside a parallel task.
+inline int parallelChunkCount(long long count, long long minChunkSize) {
+    if (parallelTaskActive()) {
+        return 1;
+    }
+
+    long long chunks = count / std::max(1LL, minChunkSize);
+    return static_cast<int>(std::max(1LL, std::min<long long>(chunks, parallelWorkerCount())));
+}
+
+// Splits [0, count) into contiguous chunks and runs task(chunk, begin, end) for each of them.
+// The first chunk runs on the calling thread, the call returns once all chunks are done.
+template<typename Task>
+void parallelChunks(long long count, int chunks, Task task) {
+    chunks = std::max(1, chunks);
+
+    if (chunks == 1) {
+        task(0, 0, count);
+        return;
+    }
+
+    auto bound = [count, chunks](int chunk) -> long long {
+        return count * chunk / chunks;
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(chunks - 1);
+
+    for (int chunk = 1; chunk < chunks; ++chunk) {
+        threads.emplace_back([&task, &bound, chunk]() {
+            ParallelTaskScope scope;
+            task(chunk, bound(chunk), bound(chunk + 1));
+        });
+    }
+
+    {
+        ParallelTaskScope scope;
+        task(0, bound(0), bound(1));
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+// Runs task(worker, index) for every index in [0, count) on a work-stealing pool.
+// Every worker starts on its own contiguous range of indices and, once that is
+// exhausted, steals the upper half of another worker's remaining range, so uneven
+// task costs still keep all workers busy. Consecutive indices tend to run on the
+// same worker, which lets tasks keep per-worker state indexed by worker.
+// Inside another parallel task, all indices run on the calling thread.
+template<typename Task>
+void parallelForStealing(long long count, int workers, Task task) {
+    struct Range {
+        std::mutex mutex;
+        long long begin;
+        long long end;
+    };
+
+    if (parallelTaskActive()) {
+        workers = 1;
+    }
+
+    workers = static_cast<int>(std::max(1LL, std::min<long long>(workers, count)));
+
+    std::unique_ptr<Range[]> ranges(new Range[workers]);
+
+    for (int worker = 0; worker < workers; ++worker) {
+        ranges[worker].begin = count * worker / workers;
+        ranges[worker].end = count * (worker + 1) / workers;
+    }
+
+    auto work = [&](int self) {
+        // a single worker leaves the cores to the kernels of its tasks
+        ParallelTaskScope scope(workers > 1);
+        Range& own = ranges[self];
+
+        for (;;) {
+            long long index = -1;
+
+            {
+                std::lock_guard<std::mutex> lock(own.mutex);
+
+                if (own.begin < own.end) {
+                    index = own.begin++;
+                }
+            }
+
+            if (index >= 0) {
+                task(self, index);
+                continue;
+            }
+
+            bool stolen = false;
+
+            for (int offset = 1; offset < workers && !stolen; ++offset) {
+                Range& victim = ranges[(self + offset) % workers];
+                long long begin = 0;
+                long long end = 0;
+
+                {
+                    std::lock_guard<std::mutex> lock(victim.mutex);
+                    long long remaining = victim.end - victim.begin;
+
+                    if (remaining > 0) {
+                        begin = victim.begin + remaining / 2;
+                        end = victim.end;
+                        victim.end = begin;
+                        stolen = true;
+                    }
+                }
+
+                if (stolen) {
+                    std::lock_guard<std::mutex> lock(own.mutex);
+                    own.begin = begin;
+                    own.end = end;
+                }
+            }
+
+            if (!stolen) {
+                return;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+
+    for (int worker = 1; worker < workers; ++worker) {
+        threads.emplace_back(work, worker);
+    }
+
+    work(0);
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+#endif // PARALLEL_H
@@ -0,0 +1,69 @@
+#ifndef PARAMETERSWEEP_H
+#define PARAMETERSWEEP_H
+
+#include <QVector>
+#include <QString>
+#include <QAtomicInt>
+
+// Evenly spaced values from..to, a single value if steps <= 1
+struct SweepRange {
+    double from;
+    double to;
+    int steps;
+
+    int count() const;
+    double value(int index) const;
+};
+
+enum SweepParameter {
+    SweepSignalA,
+    SweepSignalSigma,
+    SweepSignalMu,
+    SweepNoiseMean,
+    SweepNoiseSD
+};
+
+struct SweepParameters {
+    SweepRange signalA;
+    SweepRange signalSigma;
+    SweepRange signalMu;
+    SweepRange noiseMean;
+    SweepRange noiseSD;
+
+    int signalCount;
+    double signalStep;
+    int noiseCount;
+    double histogramBins;
+    quint64 noiseSeed;
+
+    const SweepRange& range(SweepParameter parameter) const;
+};
+
+struct SweepPoint {
+    double signalA;
+    double signalSigma;
+    double signalMu;
+    double noiseMean;
+    double noiseSD;
+
+    double signalEntropy;
+    double noiseEntropy;
+    double sumEntropy;
+};
+
+// Runs formula -> noise -> sum -> histogram -> entropy for every point of the
+// parameter grid on a work-stealing thread pool. Points are ordered with the
+// noise parameters varying fastest, so workers reuse the signal of the previous point.
+class ParameterSweep
+{
+    public:
+        // Saturates at the largest long long for absurd grids
+        static long long pointCount(const SweepParameters& parameters);
+        // Stores the points in grid order; points skipped after cancellation are left at NaN.
+        // Fails if the grid has more points than one QVector can hold.
+        static bool run(const SweepParameters& parameters, QVector<SweepPoint>& points,
+                        const QAtomicInt* canceled = 0, QString* error = 0);
+        static bool writeResults(const QVector<SweepPoint>& points, const QString& fileName);
+};
+
+#endif // PARAMETERSWEEP_H
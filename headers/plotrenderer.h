@@ -0,0 +1,50 @@
+#ifndef PLOTRENDERER_H
+#define PLOTRENDERER_H
+
+#include <QVector>
+#include <QString>
+#include <QStringList>
+#include <QImage>
+#include <QSize>
+#include <QRectF>
+#include "dsp1_signal.h"
+#include "constants.h"
+
+class QPainter;
+
+enum PlotStyle {
+    LinePlot,
+    BarPlot
+};
+
+// Data of one figure. Line plots without x values are drawn over the sample indices.
+struct PlotFigure {
+    PlotStyle style = LinePlot;
+    QVector<double> x;
+    QVector<double> y;
+
+    static PlotFigure graph(const Signal& signal);
+    static PlotFigure histogram(const Signal& signal);
+};
+
+// Lays out and draws figures with QPainter alone, without QWidget or QCustomPlot, so
+// figures can be rendered into a QImage or PDF from any thread. Text needs a
+// QGuiApplication, which the "offscreen" platform provides without a display.
+class PlotRenderer
+{
+    public:
+        explicit PlotRenderer(const QSize& size = QSize(plotExportWidth, plotExportHeight));
+
+        QSize getSize() const;
+        void render(QPainter& painter, const QRectF& rect, const PlotFigure& figure) const;
+        QImage toImage(const PlotFigure& figure) const;
+        // Writes a PDF for the suffix ".pdf" and an image in the format of the suffix otherwise
+        bool save(const PlotFigure& figure, const QString& fileName, QString* error = 0) const;
+        // Saves figures[i] to fileNames[i] on all cores
+        bool save(const QVector<PlotFigure>& figures, const QStringList& fileNames, QString* error = 0) const;
+
+    private:
+        QSize size;
+};
+
+#endif // PLOTRENDERER_H
@@ -0,0 +1,28 @@
+#ifndef PROBABILITYMODEL_H
+#define PROBABILITYMODEL_H
+
+#include <QAbstractTableModel>
+#include "dsp1_signal.h"
+
+// Read-only bin/probability table over a signal's histogram.
+// The vectors are shared with the signal (no copy) and cells are formatted on demand.
+class ProbabilityTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    explicit ProbabilityTableModel(QObject *parent = 0);
+
+    void setSignal(const Signal& signal);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    QVector<double> bins;
+    QVector<double> probability;
+};
+
+#endif // PROBABILITYMODEL_H
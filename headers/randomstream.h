@@ -0,0 +1,58 @@
+#ifndef RANDOMSTREAM_H
+#define RANDOMSTREAM_H
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <QtGlobal>
+
+// Counter-based random numbers: the n-th value of a stream depends only on (seed, stream, n),
+// so streams can be generated on any thread and in any order with identical results.
+// Values are produced by hashing the counter with the splitmix64 finalizer.
+class RandomStream
+{
+    public:
+        RandomStream(quint64 seed, quint64 stream) :
+            key(mix(seed + goldenGamma * (stream + 1))), counter(0), spare(0), hasSpare(false) {
+        }
+
+        quint64 nextBits() {
+            return mix(key + goldenGamma * ++counter);
+        }
+
+        // uniform on (0, 1]
+        double nextUniform() {
+            return ((nextBits() >> 11) + 1) * (1.0 / 9007199254740992.0);
+        }
+
+        // standard normal, Box-Muller transform
+        double nextNormal() {
+            if (hasSpare) {
+                hasSpare = false;
+                return spare;
+            }
+
+            double radius = sqrt(-2 * log(nextUniform()));
+            double angle = 2 * M_PI * nextUniform();
+
+            spare = radius * sin(angle);
+            hasSpare = true;
+
+            return radius * cos(angle);
+        }
+
+    private:
+        static const quint64 goldenGamma = 0x9e3779b97f4a7c15ULL;
+
+        static quint64 mix(quint64 z) {
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        }
+
+        quint64 key;
+        quint64 counter;
+        double spare;
+        bool hasSpare;
+};
+
+#endif // RANDOMSTREAM_H
@@ -0,0 +1,69 @@
+#ifndef SAMPLES_H
+#define SAMPLES_H
+
+#include <QtGlobal>
+#include <math.h>
+#include <type_traits>
+
+// Storage formats of Signal samples, the values double as signal file sample type codes
+enum SampleFormat {
+    Float64Format = 1,
+    Float32Format = 2,
+    Int16Format = 3
+};
+
+inline int sampleFormatSize(SampleFormat format) {
+    return format == Int16Format ? 2 : format == Float32Format ? 4 : 8;
+}
+
+// Non-owning view of contiguous samples in any storage format
+struct SampleView {
+    const void* data;
+    int size;
+    SampleFormat format;
+};
+
+// Calls function(data) with the samples of view as a pointer to their storage type,
+// so every kernel is instantiated once per format instead of converting samples to double
+template<typename Function>
+auto visitSamples(const SampleView& view, Function function) -> decltype(function(static_cast<const double*>(0))) {
+    switch (view.format) {
+        case Float32Format:
+            return function(static_cast<const float*>(view.data));
+        case Int16Format:
+            return function(static_cast<const qint16*>(view.data));
+        default:
+            return function(static_cast<const double*>(view.data));
+    }
+}
+
+// Storage type behind a sample pointer of visitSamples, e.g. SampleType<decltype(data)>
+template<typename Pointer>
+using SampleType = typename std::remove_const<typename std::remove_pointer<Pointer>::type>::type;
+
+// Converts a computed value to a storage type. Integer samples are rounded to
+// the nearest value and saturated instead of wrapping around, NaN becomes 0.
+template<typename T>
+inline T sampleCast(double value) {
+    return static_cast<T>(value);
+}
+
+template<>
+inline qint16 sampleCast<qint16>(double value) {
+    if (!(value == value)) {
+        return 0;
+    }
+
+    double rounded = floor(value + 0.5);
+
+    if (rounded <= -32768) {
+        return -32768;
+    }
+    if (rounded >= 32767) {
+        return 32767;
+    }
+
+    return static_cast<qint16>(rounded);
+}
+
+#endif // SAMPLES_H
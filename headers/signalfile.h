@@ -0,0 +1,80 @@
+#ifndef SIGNALFILE_H
+#define SIGNALFILE_H
+
+#include <QFile>
+#include <QString>
+#include <memory>
+#include "dsp1_signal.h"
+
+// Binary signal file: a 64-byte little-endian header followed by sampleCount raw
+// little-endian samples at dataOffset, stored as the SampleFormat given by sampleType.
+// Readers skip unknown header bytes, so later versions may grow the header
+// as long as dataOffset stays a multiple of 8.
+const char signalFileMagic[8] = {'D', 'S', 'P', '1', 'S', 'I', 'G', '\0'};
+const quint32 signalFileVersion = 1;
+const int signalFileHeaderSize = 64;
+
+struct SignalFileHeader {
+    quint32 version;
+    SampleFormat sampleType;
+    quint64 sampleCount;
+    quint64 dataOffset;
+    double step;
+};
+
+// Reads and validates the header of an open signal file, large files are accepted
+bool readSignalFileHeader(QFile& file, SignalFileHeader& header, QString* error = 0);
+
+// Converts count samples read from a signal file to host byte order in place
+void signalFileToHostOrder(void* samples, long long count, SampleFormat type);
+
+// Read-only memory mapping of a signal file. On little-endian hosts the samples are
+// viewed in place in their stored format; otherwise they are byte-swapped once into an owned buffer.
+class MappedSignalFile
+{
+    public:
+        // Returns null and sets error if the file cannot be opened or is not a valid signal file
+        static std::shared_ptr<const MappedSignalFile> open(const QString& fileName, QString* error = 0);
+
+        const SignalFileHeader& getHeader() const;
+        SampleView getView() const;
+        bool isZeroCopy() const;
+    private:
+        MappedSignalFile();
+
+        QFile file;
+        SignalFileHeader header;
+        const uchar* mapping;
+        // 8-byte words keep the converted samples of every format aligned
+        QVector<quint64> converted;
+        SampleView samples;
+};
+
+// Appends samples to a new signal file block by block, so files of any length can be
+// written with bounded memory. The sample count in the header is set by close().
+class SignalFileWriter
+{
+    public:
+        SignalFileWriter();
+        ~SignalFileWriter();
+        bool open(const QString& fileName, SampleFormat format, double step = 0);
+        // Samples are converted to the format of the file
+        bool write(const SampleView& samples);
+        bool close();
+        qint64 getCount() const;
+    private:
+        QFile file;
+        SampleFormat format;
+        double step;
+        qint64 count;
+        bool failed;
+};
+
+// Writes samples as a signal file of the given type, step is stored as metadata only
+bool writeSignalFile(const SampleSpan& samples, const QString& fileName,
+                     SampleFormat type = Float64Format, double step = 0);
+
+// Writes samples in their own format
+bool writeSignalFile(const SampleView& samples, const QString& fileName, double step = 0);
+
+#endif // SIGNALFILE_H
@@ -1,4 +1,26 @@
 #ifndef SIGNALGENERATORS_H
 #define SIGNALGENERATORS_H
 
+#include <QtGlobal>
+
+// Fills output[0, count) with the Gaussian-modulated chirp of Signal::setByFormula.
+// Uses AVX2 or SSE2 kernels when the CPU supports them and falls back to scalar code otherwise.
+void generateFormula(double* output, int count, double step, double a, double sigma, double mu);
+
+// How noise is limited to [lowBoundary, highBoundary]:
+// RejectionSampling redraws N(mean, sd) until the value fits, which never ends when the
+// boundaries cover almost none of the Gaussian mass. TruncatedSampling draws from the
+// truncated normal directly (Robert, 1995) at O(1) expected cost per sample.
+enum NoiseSampling {
+    RejectionSampling,
+    TruncatedSampling
+};
+
+// Fills output[0, count) with N(mean, sd) noise limited to [lowBoundary, highBoundary].
+// Every sample draws from its own RandomStream, so the result for a given seed
+// does not depend on how many threads generate it.
+void generateNoise(double* output, int count, double mean, double sd,
+                   double lowBoundary, double highBoundary, quint64 seed,
+                   NoiseSampling sampling = TruncatedSampling);
+
 #endif // SIGNALGENERATORS_H
@@ -0,0 +1,11 @@
+#ifndef SIGNALIO_H
+#define SIGNALIO_H
+
+#include <QString>
+#include "dsp1_signal.h"
+
+// Writes the bin/probability table of signal as text straight from its histogram,
+// through a fixed-size buffer, so memory use does not depend on the number of bins
+bool writeProbabilityTable(const Signal& signal, const QString& fileName);
+
+#endif // SIGNALIO_H
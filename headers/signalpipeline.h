@@ -0,0 +1,84 @@
+#ifndef SIGNALPIPELINE_H
+#define SIGNALPIPELINE_H
+
+#include <QObject>
+#include <QMap>
+#include <QFuture>
+#include <QAtomicInt>
+#include <QCache>
+#include <QMutex>
+#include <functional>
+#include "dsp1_signal.h"
+
+typedef QMap<QString, Signal> SignalMap;
+
+struct PipelineParameters {
+    int signalCount;
+    double signalStep;
+    double signalA;
+    double signalSigma;
+    double signalMu;
+
+    int noiseCount;
+    double noiseMean;
+    double noiseSD;
+
+    double histogramBins;
+
+    quint64 noiseSeed;
+};
+
+// Memoized pipeline results. Every stage is keyed by a hash of its own parameters
+// and of the keys of the stages it depends on, so a parameter change only
+// invalidates the stages downstream of it.
+class PipelineCache
+{
+    public:
+        explicit PipelineCache(int maxCost);
+        bool find(quint64 key, Signal& result);
+        void insert(quint64 key, const Signal& result, int cost);
+        void clear();
+    private:
+        QCache<quint64, Signal> results;
+        QMutex mutex;
+};
+
+// Computes signal -> noise -> sum -> convolution -> histograms on a worker thread.
+// Progress and results are delivered through queued signals, so slots run on the receiver's thread.
+class SignalPipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    typedef std::function<void(int percent, const QString& stage)> ProgressCallback;
+
+    explicit SignalPipeline(QObject *parent = 0);
+    ~SignalPipeline();
+
+    // Returns false if a computation is still running
+    bool start(const PipelineParameters& parameters);
+    // Cancellation takes effect at the next stage boundary
+    void cancel();
+    void wait();
+    bool isRunning() const;
+
+    // Runs the pipeline on the calling thread, returns an empty map if canceled.
+    // Stages found in the cache are reused instead of being recomputed.
+    static SignalMap compute(const PipelineParameters& parameters, const QAtomicInt& canceled,
+                             const ProgressCallback& progress = ProgressCallback(),
+                             PipelineCache* cache = 0);
+
+signals:
+    void progressChanged(int percent, const QString& stage);
+    void finished(const SignalMap& data);
+    void canceled();
+
+private:
+    void run(const PipelineParameters& parameters);
+
+    QFuture<void> future;
+    QAtomicInt cancelRequested;
+    PipelineCache cache;
+};
+
+#endif // SIGNALPIPELINE_H
@@ -0,0 +1,49 @@
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include <QVector>
+#include "histogram.h"
+
+struct SignalStatistics {
+    long long count;
+    double min;
+    double max;
+    double mean;
+    double variance;    // sample variance, divided by count - 1
+    double skewness;
+    double kurtosis;    // excess kurtosis, 0 for a normal distribution
+};
+
+// Count, mean and central moment sums of a sample set.
+// Partial results are combined with the pairwise update of Chan et al. / Pebay.
+struct MomentAccumulator {
+    long long count;
+    double mean;
+    double m2;
+    double m3;
+    double m4;
+    double min;
+    double max;
+
+    MomentAccumulator();
+    void merge(const MomentAccumulator& other);
+    SignalStatistics statistics() const;
+};
+
+// Single cache-friendly pass over data computing min, max and moments.
+// Instantiated for double, float and qint16 samples.
+template<typename T>
+SignalStatistics computeStatistics(const T* data, long long size);
+
+// Same pass that also fills counts (resized to layout.size) with the samples per bin
+template<typename T>
+SignalStatistics computeStatistics(const T* data, long long size,
+                                   const HistogramLayout& layout, QVector<qint64>& counts);
+
+// Serial form of the same pass that adds data[0, size) to accumulator, and to counts if
+// layout is given. For callers that split the work themselves, e.g. page by page.
+template<typename T>
+void accumulateMoments(const T* data, long long size, MomentAccumulator& accumulator,
+                       const HistogramLayout* layout = 0, qint64* counts = 0);
+
+#endif // STATISTICS_H
@@ -0,0 +1,34 @@
+#ifndef STREAMCONVOLVER_H
+#define STREAMCONVOLVER_H
+
+#include <QVector>
+#include "fft.h"
+
+// Block-based overlap-add convolution of an input stream with a fixed kernel.
+// Memory use depends only on the kernel and block sizes, never on the stream length.
+// Output is the plain linear convolution (input * kernel) in natural order,
+// unlike Signal::setByConvolution which stores it reversed.
+class StreamConvolver
+{
+    public:
+        explicit StreamConvolver(const QVector<double>& kernel, int blockSize = 0);
+        QVector<double> process(const QVector<double>& chunk);
+        QVector<double> process(const double* chunk, int size);
+        QVector<double> flush();
+        void reset();
+        int getBlockSize() const;
+        int getKernelSize() const;
+    private:
+        void convolveBlock(int size, QVector<double>& output);
+
+        QVector<Complex> kernelSpectrum;
+        QVector<Complex> workspace;
+        QVector<double> pending;
+        QVector<double> overlap;
+        int kernelSize;
+        int blockSize;
+        int transformSize;
+        int pendingSize;
+};
+
+#endif // STREAMCONVOLVER_H
@@ -706,6 +706,81 @@ void QCPPaintBufferPixmap::reallocateBuffer()
   }
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPPaintBufferImage
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPPaintBufferImage
+  \brief A paint buffer based on QImage, using software raster rendering
+
+  This paint buffer renders into a QImage of format QImage::Format_ARGB32_Premultiplied. Unlike
+  QPixmap, a QImage doesn't depend on the windowing system, so this buffer can be painted from any
+  thread. It is used if \ref QCustomPlot::setRasterBuffer is set to \ref QCustomPlot::rbImage or
+  \ref QCustomPlot::setThreadedReplot is true.
+
+  On platforms without a windowing system (for example the "offscreen" and "linuxfb" platforms on
+  headless Linux), pixmaps are images internally anyway. There, and for plots that are rendered in
+  the background or read back with \ref image, this buffer avoids the conversions of
+  QCPPaintBufferPixmap. Compositing it onto a raster surface is a plain premultiplied blend.
+*/
+
+/*!
+  Creates an image paint buffer instance with the specified \a size and \a devicePixelRatio, if
+  applicable.
+*/
+QCPPaintBufferImage::QCPPaintBufferImage(const QSize &size, double devicePixelRatio) :
+  QCPAbstractPaintBuffer(size, devicePixelRatio)
+{
+  QCPPaintBufferImage::reallocateBuffer();
+}
+
+QCPPaintBufferImage::~QCPPaintBufferImage()
+{
+}
+
+/* inherits documentation from base class */
+QCPPainter *QCPPaintBufferImage::startPainting()
+{
+  QCPPainter *result = new QCPPainter(&mBuffer);
+  result->setRenderHint(QPainter::HighQualityAntialiasing);
+  return result;
+}
+
+/* inherits documentation from base class */
+void QCPPaintBufferImage::draw(QCPPainter *painter) const
+{
+  if (painter && painter->isActive())
+    painter->drawImage(0, 0, mBuffer);
+  else
+    qDebug() << Q_FUNC_INFO << "invalid or inactive painter passed";
+}
+
+/* inherits documentation from base class */
+void QCPPaintBufferImage::clear(const QColor &color)
+{
+  mBuffer.fill(color);
+}
+
+/* inherits documentation from base class */
+void QCPPaintBufferImage::reallocateBuffer()
+{
+  setInvalidated();
+  if (!qFuzzyCompare(1.0, mDevicePixelRatio))
+  {
+#ifdef QCP_DEVICEPIXELRATIO_SUPPORTED
+    mBuffer = QImage(mSize*mDevicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+    mBuffer.setDevicePixelRatio(mDevicePixelRatio);
+#else
+    qDebug() << Q_FUNC_INFO << "Device pixel ratios not supported for Qt versions before 5.4";
+    mDevicePixelRatio = 1.0;
+    mBuffer = QImage(mSize, QImage::Format_ARGB32_Premultiplied);
+#endif
+  } else
+  {
+    mBuffer = QImage(mSize, QImage::Format_ARGB32_Premultiplied);
+  }
+}
+
 
 #ifdef QCP_OPENGL_PBUFFER
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -12613,6 +12688,8 @@ QCustomPlot::QCustomPlot(QWidget *parent) :
   mSelectionRectMode(QCP::srmNone),
   mSelectionRect(0),
   mOpenGl(false),
+  mThreadedReplot(false),
+  mRasterBuffer(rbPixmap),
   mMouseHasMoved(false),
   mMouseEventLayerable(0),
   mReplotting(false),
@@ -13087,6 +13164,65 @@ void QCustomPlot::setOpenGl(bool enabled, int multisampling)
 #endif
 }
 
+/*!
+  Sets the type of paint buffers that are used when OpenGL is disabled (see \ref setOpenGl). By
+  default, the paint buffers are pixmaps (\ref rbPixmap).
+
+  \ref rbImage selects \ref QCPPaintBufferImage, which renders into QImages of format
+  QImage::Format_ARGB32_Premultiplied. Choose it on headless or framebuffer platforms and when the
+  paint buffers are painted outside the GUI thread.
+
+  All paint buffers are recreated, so the next \ref replot draws all layers.
+
+  \see setThreadedReplot
+*/
+void QCustomPlot::setRasterBuffer(RasterBuffer type)
+{
+  if (mRasterBuffer != type)
+  {
+    mRasterBuffer = type;
+    // recreate all paint buffers:
+    mPaintBuffers.clear();
+    setupPaintBuffers();
+  }
+}
+
+/*!
+  Sets whether \ref replot draws the paint buffers concurrently on the global thread pool.
+
+  Layers share a paint buffer unless they are in mode \ref QCPLayer::lmBuffered (see \ref
+  QCPLayer::setMode). If \a enabled is true, the group of layers of each paint buffer is drawn by
+  a separate task, and the buffers are composited on the GUI thread as usual. To make use of
+  multiple cores, put expensive layers (for example the "main" layer with the graphs) into
+  buffered mode, so they are drawn concurrently with the grid and the axes.
+
+  Threaded replots use paint buffers of type \ref QCPPaintBufferImage regardless of \ref
+  setRasterBuffer, since pixmaps can't be painted outside the GUI thread. For the same reason, tick
+  labels aren't cached during threaded replots. Layerables that draw pixmaps themselves, such as
+  axis rect backgrounds, \ref QCPItemPixmap or pixmap scatter styles, require a platform that
+  supports pixmaps in threads. A partial replot with \ref QCPLayer::replot and plots with \ref
+  setOpenGl enabled are drawn sequentially.
+
+  \note Threaded replots are only available if QCustomPlot is compiled with the macro \c
+  QCUSTOMPLOT_USE_CONCURRENT defined and the module "concurrent" added to the \c QT variable of the
+  qmake project file.
+*/
+void QCustomPlot::setThreadedReplot(bool enabled)
+{
+#ifdef QCP_CONCURRENT
+  if (mThreadedReplot != enabled)
+  {
+    mThreadedReplot = enabled;
+    // recreate all paint buffers:
+    mPaintBuffers.clear();
+    setupPaintBuffers();
+  }
+#else
+  Q_UNUSED(enabled)
+  qDebug() << Q_FUNC_INFO << "QCustomPlot can't replot in threads because QCUSTOMPLOT_USE_CONCURRENT was not defined during compilation (add 'DEFINES += QCUSTOMPLOT_USE_CONCURRENT' and 'QT += concurrent' to your qmake .pro file)";
+#endif
+}
+
 /*!
   Sets the viewport of this QCustomPlot. Usually users of QCustomPlot don't need to change the
   viewport manually.
@@ -14149,8 +14285,13 @@ void QCustomPlot::replot(QCustomPlot::RefreshPriority refreshPriority)
   updateLayout();
   // draw all layered objects (grid, axes, plottables, items, legend,...) into their buffers:
   setupPaintBuffers();
-  foreach (QCPLayer *layer, mLayers)
-    layer->drawToPaintBuffer();
+  if (mThreadedReplot && !mOpenGl)
+    drawToPaintBuffersConcurrently();
+  else
+  {
+    foreach (QCPLayer *layer, mLayers)
+      layer->drawToPaintBuffer();
+  }
   for (int i=0; i<mPaintBuffers.size(); ++i)
     mPaintBuffers.at(i)->setInvalidated(false);
   
@@ -14829,9 +14970,10 @@ void QCustomPlot::setupPaintBuffers()
 
   This method is used by \ref setupPaintBuffers when it needs to create new paint buffers.
 
-  Depending on the current setting of \ref setOpenGl, and the current Qt version, different
-  backends (subclasses of \ref QCPAbstractPaintBuffer) are created, initialized with the proper
-  size and device pixel ratio, and returned.
+  Depending on the current setting of \ref setOpenGl, \ref setRasterBuffer and \ref
+  setThreadedReplot, and the current Qt version, different backends (subclasses of \ref
+  QCPAbstractPaintBuffer) are created, initialized with the proper size and device pixel ratio, and
+  returned.
 */
 QCPAbstractPaintBuffer *QCustomPlot::createPaintBuffer()
 {
@@ -14845,10 +14987,70 @@ QCPAbstractPaintBuffer *QCustomPlot::createPaintBuffer()
     qDebug() << Q_FUNC_INFO << "OpenGL enabled even though no support for it compiled in, this shouldn't have happened. Falling back to pixmap paint buffer.";
     return new QCPPaintBufferPixmap(viewport().size(), mBufferDevicePixelRatio);
 #endif
-  } else
+  } else if (mRasterBuffer == rbImage || mThreadedReplot)
+    return new QCPPaintBufferImage(viewport().size(), mBufferDevicePixelRatio);
+  else
     return new QCPPaintBufferPixmap(viewport().size(), mBufferDevicePixelRatio);
 }
 
+/*! \internal
+
+  Draws the layers into their paint buffers like \ref QCPLayer::drawToPaintBuffer, but with one
+  task per paint buffer on the global thread pool (see \ref setThreadedReplot). Returns when all
+  buffers are drawn.
+*/
+void QCustomPlot::drawToPaintBuffersConcurrently()
+{
+#ifdef QCP_CONCURRENT
+  // group the layers by paint buffer, keeping their order within each group:
+  QVector<QList<QCPLayer*> > layerGroups(mPaintBuffers.size());
+  int bufferIndex = 0;
+  foreach (QCPLayer *layer, mLayers)
+  {
+    int index = bufferIndex;
+    while (index < mPaintBuffers.size() && mPaintBuffers.at(index).data() != layer->mPaintBuffer.data())
+      ++index;
+    if (index < mPaintBuffers.size())
+    {
+      layerGroups[index].append(layer);
+      bufferIndex = index;
+    } else
+      qDebug() << Q_FUNC_INFO << "no valid paint buffer associated with layer" << layer->name();
+  }
+  QtConcurrent::blockingMap(layerGroups, drawLayerGroup);
+#else
+  foreach (QCPLayer *layer, mLayers)
+    layer->drawToPaintBuffer();
+#endif
+}
+
+#ifdef QCP_CONCURRENT
+/*! \internal
+
+  Draws the \a layers, which all share one paint buffer, into that buffer with a single painter.
+  This is the task run by \ref drawToPaintBuffersConcurrently, so it may run outside the GUI thread.
+*/
+void QCustomPlot::drawLayerGroup(QList<QCPLayer*> &layers)
+{
+  if (layers.isEmpty())
+    return;
+  QCPAbstractPaintBuffer *buffer = layers.first()->mPaintBuffer.data();
+  if (QCPPainter *painter = buffer->startPainting())
+  {
+    if (painter->isActive())
+    {
+      painter->setMode(QCPPainter::pmNoCaching); // cached labels are pixmaps, which can't be created outside the GUI thread
+      foreach (QCPLayer *layer, layers)
+        layer->draw(painter);
+    } else
+      qDebug() << Q_FUNC_INFO << "paint buffer returned inactive painter";
+    delete painter;
+    buffer->donePainting();
+  } else
+    qDebug() << Q_FUNC_INFO << "paint buffer returned zero painter";
+}
+#endif
+
 /*!
   This method returns whether any of the paint buffers held by this QCustomPlot instance are
   invalidated.
@@ -19715,6 +19917,232 @@ QCPGraphData::QCPGraphData(double key, double value) :
 }
 
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPGraphValuePyramid
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPGraphValuePyramid
+  \brief Min/max index over the values of a QCPGraphDataContainer, used by QCPGraph for fast adaptive sampling.
+  
+  The lowest level holds the value range of every block of \ref BlockSize consecutive data points,
+  each higher level the value ranges of pairs of entries of the level below. The value range of
+  any index interval of the container can thus be determined by scanning at most two partial
+  blocks plus O(log n) pyramid entries, instead of every data point.
+  
+  NaN values are ignored. Entries that only cover NaN values have a lower bound of +infinity and an
+  upper bound of -infinity.
+  
+  The pyramid doesn't observe the container. It must be rebuilt with \ref build or brought up to
+  date with \ref update whenever the container changes. \ref update only recomputes the blocks
+  touched by data that was appended at the end of the container, and falls back to a full rebuild
+  otherwise.
+  
+  \see QCPGraph::setAdaptiveSamplingIndex
+*/
+
+/*!
+  Constructs an empty pyramid.
+*/
+QCPGraphValuePyramid::QCPGraphValuePyramid() :
+  mCount(0),
+  mFirstKey(0),
+  mLastKey(0),
+  mFirstValue(0),
+  mLastValue(0)
+{
+}
+
+/*!
+  Returns whether the pyramid was built for a container that, as far as can be checked cheaply,
+  equals \a data or is a prefix of it, i.e. whether \ref update can extend it incrementally. The
+  check compares the keys and values of the first and last data point the pyramid covers.
+  
+  Changes of values made in place that leave both of these data points unchanged can't be
+  detected.
+*/
+bool QCPGraphValuePyramid::isValidFor(const QCPGraphDataContainer &data) const
+{
+  if (mLevels.isEmpty() || data.size() < mCount)
+    return false;
+  const QCPGraphData &first = *data.constBegin();
+  const QCPGraphData &last = *(data.constBegin()+mCount-1);
+  return first.key == mFirstKey && last.key == mLastKey &&
+         (first.value == mFirstValue || (qIsNaN(first.value) && qIsNaN(mFirstValue))) &&
+         (last.value == mLastValue || (qIsNaN(last.value) && qIsNaN(mLastValue)));
+}
+
+/*!
+  Discards the current pyramid and builds it from scratch for \a data.
+*/
+void QCPGraphValuePyramid::build(const QCPGraphDataContainer &data)
+{
+  clear();
+  rebuildFrom(data, 0);
+}
+
+/*!
+  Brings the pyramid up to date with \a data. If the data was only appended to since the last call
+  of \ref build or \ref update, only the blocks containing new data points (and their parents) are
+  recomputed. Otherwise the pyramid is rebuilt completely.
+*/
+void QCPGraphValuePyramid::update(const QCPGraphDataContainer &data)
+{
+  if (isValidFor(data))
+  {
+    if (data.size() != mCount)
+      rebuildFrom(data, mCount/BlockSize);
+  } else
+    build(data);
+}
+
+/*!
+  Discards all levels of the pyramid.
+*/
+void QCPGraphValuePyramid::clear()
+{
+  mLevels.clear();
+  mCount = 0;
+  mFirstKey = 0;
+  mLastKey = 0;
+  mFirstValue = 0;
+  mLastValue = 0;
+}
+
+/*!
+  Returns the range of the values of the data points with indices \a begin (inclusive) to \a end
+  (exclusive) in \a data, ignoring NaN values. If the interval contains no values other than NaN,
+  both bounds of the returned range are NaN.
+  
+  The pyramid must be valid for \a data (see \ref isValidFor) and \a end must not exceed the size
+  the pyramid was built for.
+*/
+QCPRange QCPGraphValuePyramid::valueBounds(const QCPGraphDataContainer &data, int begin, int end) const
+{
+  double lower = std::numeric_limits<double>::infinity();
+  double upper = -std::numeric_limits<double>::infinity();
+  
+  int blockBegin = (begin+BlockSize-1)/BlockSize;
+  int blockEnd = end/BlockSize;
+  // data points outside of the complete blocks are scanned directly:
+  int scanEnds[2] = {end, begin};
+  if (blockBegin < blockEnd)
+  {
+    scanEnds[0] = blockBegin*BlockSize;
+    scanEnds[1] = blockEnd*BlockSize;
+  }
+  for (int i=begin; i<scanEnds[0]; ++i)
+  {
+    const double value = (data.constBegin()+i)->value;
+    if (value < lower) lower = value;
+    if (value > upper) upper = value;
+  }
+  for (int i=scanEnds[1]; i<end; ++i)
+  {
+    const double value = (data.constBegin()+i)->value;
+    if (value < lower) lower = value;
+    if (value > upper) upper = value;
+  }
+  // complete blocks are combined from the pyramid levels, climbing up while the interval is aligned:
+  for (int level=0; level<mLevels.size() && blockBegin < blockEnd; ++level)
+  {
+    const QVector<QCPRange> &ranges = mLevels.at(level);
+    if (blockBegin & 1)
+    {
+      if (ranges.at(blockBegin).lower < lower) lower = ranges.at(blockBegin).lower;
+      if (ranges.at(blockBegin).upper > upper) upper = ranges.at(blockBegin).upper;
+      ++blockBegin;
+    }
+    if (blockEnd & 1)
+    {
+      --blockEnd;
+      if (ranges.at(blockEnd).lower < lower) lower = ranges.at(blockEnd).lower;
+      if (ranges.at(blockEnd).upper > upper) upper = ranges.at(blockEnd).upper;
+    }
+    blockBegin /= 2;
+    blockEnd /= 2;
+  }
+  
+  QCPRange result; // assign bounds directly, the constructor would swap the empty bounds
+  if (lower > upper)
+  {
+    result.lower = qQNaN();
+    result.upper = qQNaN();
+  } else
+  {
+    result.lower = lower;
+    result.upper = upper;
+  }
+  return result;
+}
+
+/*! \internal
+  
+  Recomputes all blocks starting at block index \a firstBlock of the lowest level and their parent
+  entries on all higher levels, resizing the levels to the current size of \a data.
+*/
+void QCPGraphValuePyramid::rebuildFrom(const QCPGraphDataContainer &data, int firstBlock)
+{
+  mCount = data.size();
+  if (mCount == 0)
+  {
+    clear();
+    return;
+  }
+  mFirstKey = data.constBegin()->key;
+  mLastKey = (data.constEnd()-1)->key;
+  mFirstValue = data.constBegin()->value;
+  mLastValue = (data.constEnd()-1)->value;
+  
+  QCPRange empty;
+  empty.lower = std::numeric_limits<double>::infinity();
+  empty.upper = -std::numeric_limits<double>::infinity();
+  
+  // lowest level, from the data points:
+  if (mLevels.isEmpty())
+    mLevels.append(QVector<QCPRange>());
+  QVector<QCPRange> &blocks = mLevels[0];
+  blocks.resize((mCount+BlockSize-1)/BlockSize);
+  for (int block=firstBlock; block<blocks.size(); ++block)
+  {
+    QCPRange range = empty;
+    QCPGraphDataContainer::const_iterator it = data.constBegin()+block*BlockSize;
+    const QCPGraphDataContainer::const_iterator itEnd = data.constBegin()+qMin(mCount, (block+1)*BlockSize);
+    while (it != itEnd)
+    {
+      if (it->value < range.lower) range.lower = it->value;
+      if (it->value > range.upper) range.upper = it->value;
+      ++it;
+    }
+    blocks[block] = range;
+  }
+  
+  // higher levels, from pairs of entries of the level below:
+  int level = 0;
+  while (mLevels.at(level).size() > 1)
+  {
+    const int childCount = mLevels.at(level).size();
+    if (mLevels.size() == level+1)
+      mLevels.append(QVector<QCPRange>());
+    firstBlock /= 2;
+    QVector<QCPRange> &parents = mLevels[level+1];
+    const QVector<QCPRange> &children = mLevels.at(level);
+    parents.resize((childCount+1)/2);
+    for (int i=firstBlock; i<parents.size(); ++i)
+    {
+      QCPRange range = children.at(2*i);
+      if (2*i+1 < childCount)
+      {
+        if (children.at(2*i+1).lower < range.lower) range.lower = children.at(2*i+1).lower;
+        if (children.at(2*i+1).upper > range.upper) range.upper = children.at(2*i+1).upper;
+      }
+      parents[i] = range;
+    }
+    ++level;
+  }
+  mLevels.resize(level+1);
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////// QCPGraph
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -19793,6 +20221,7 @@ QCPGraph::QCPGraph(QCPAxis *keyAxis, QCPAxis *valueAxis) :
   setScatterSkip(0);
   setChannelFillGraph(0);
   setAdaptiveSampling(true);
+  setAdaptiveSamplingIndex(false);
 }
 
 QCPGraph::~QCPGraph()
@@ -19817,6 +20246,8 @@ QCPGraph::~QCPGraph()
 void QCPGraph::setData(QSharedPointer<QCPGraphDataContainer> data)
 {
   mDataContainer = data;
+  if (mAdaptiveSamplingIndex)
+    mValuePyramid.build(*mDataContainer);
 }
 
 /*! \overload
@@ -19833,6 +20264,8 @@ void QCPGraph::setData(QSharedPointer<QCPGraphDataContainer> data)
 void QCPGraph::setData(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted)
 {
   mDataContainer->clear();
+  // new values often come under the same keys, which the pyramid can't tell from appended data:
+  mValuePyramid.clear();
   addData(keys, values, alreadySorted);
 }
 
@@ -19939,6 +20372,32 @@ void QCPGraph::setAdaptiveSampling(bool enabled)
   mAdaptiveSampling = enabled;
 }
 
+/*!
+  Sets whether adaptive sampling of lines (see \ref setAdaptiveSampling) shall use a min/max index
+  of the data values, a \ref QCPGraphValuePyramid. Without the index, adaptive sampling visits every
+  visible data point on each replot. With the index, it determines the value range of each pixel
+  column in logarithmic time, so replots of graphs with millions of points only cost in proportion
+  to the number of pixel columns. The output is the same in both cases.
+  
+  The index is built when \a enabled is true, and on every call of \ref setData. \ref addData
+  updates it incrementally when the new points are appended behind the existing keys, which is the
+  usual case for realtime data. The index occupies about 1/32 of the memory of the data.
+  
+  If the data is modified directly via \ref data, the index is brought up to date on the next replot
+  as long as the first or last data point reveals the change. After modifying values in place, call this
+  method with \a enabled set to true again to rebuild the index.
+  
+  By default, the index is disabled.
+*/
+void QCPGraph::setAdaptiveSamplingIndex(bool enabled)
+{
+  mAdaptiveSamplingIndex = enabled;
+  if (mAdaptiveSamplingIndex)
+    mValuePyramid.build(*mDataContainer);
+  else
+    mValuePyramid.clear();
+}
+
 /*! \overload
   
   Adds the provided points in \a keys and \a values to the current data. The provided vectors
@@ -19968,6 +20427,8 @@ void QCPGraph::addData(const QVector<double> &keys, const QVector<double> &value
     ++i;
   }
   mDataContainer->add(tempData, alreadySorted); // don't modify tempData beyond this to prevent copy on write
+  if (mAdaptiveSamplingIndex)
+    mValuePyramid.update(*mDataContainer);
 }
 
 /*! \overload
@@ -19980,6 +20441,8 @@ void QCPGraph::addData(const QVector<double> &keys, const QVector<double> &value
 void QCPGraph::addData(double key, double value)
 {
   mDataContainer->add(QCPGraphData(key, value));
+  if (mAdaptiveSamplingIndex)
+    mValuePyramid.update(*mDataContainer);
 }
 
 /* inherits documentation from base class */
@@ -20576,72 +21039,249 @@ void QCPGraph::getOptimizedLineData(QVector<QCPGraphData> *lineData, const QCPGr
       maxCount = 2*keyPixelSpan+2;
   }
   
-  if (mAdaptiveSampling && dataCount >= maxCount) // use adaptive sampling only if there are at least two points per pixel on average
+  if (mAdaptiveSampling && mAdaptiveSamplingIndex && dataCount >= maxCount) // use the value pyramid to sample the data
+  {
+    getIndexedLineData(lineData, begin, end);
+  } else if (mAdaptiveSampling && dataCount >= maxCount) // use adaptive sampling only if there are at least two points per pixel on average
   {
-    QCPGraphDataContainer::const_iterator it = begin;
-    double minValue = it->value;
-    double maxValue = it->value;
-    QCPGraphDataContainer::const_iterator currentIntervalFirstPoint = it;
     int reversedFactor = keyAxis->pixelOrientation(); // is used to calculate keyEpsilon pixel into the correct direction
     int reversedRound = reversedFactor==-1 ? 1 : 0; // is used to switch between floor (normal) and ceil (reversed) rounding of currentIntervalStartKey
     double currentIntervalStartKey = keyAxis->pixelToCoord((int)(keyAxis->coordToPixel(begin->key)+reversedRound));
-    double lastIntervalEndKey = currentIntervalStartKey;
     double keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+1.0*reversedFactor)); // interval of one pixel on screen when mapped to plot key coordinates
-    bool keyEpsilonVariable = keyAxis->scaleType() == QCPAxis::stLogarithmic; // indicates whether keyEpsilon needs to be updated after every interval (for log axes)
-    int intervalDataCount = 1;
-    ++it; // advance iterator to second data point because adaptive sampling works in 1 point retrospect
+#ifdef QCP_CONCURRENT
+    getParallelSampledLineData(lineData, begin, end, currentIntervalStartKey, keyEpsilon);
+#else
+    getSampledLineData(lineData, begin, end, end, currentIntervalStartKey, keyEpsilon);
+#endif
+  } else // don't use adaptive sampling algorithm, transfer points one-to-one from the data container into the output
+  {
+    QCPGraphDataContainer::const_iterator it = begin;
+    lineData->reserve(dataCount+2); // +2 for possible fill end points
     while (it != end)
     {
-      if (it->key < currentIntervalStartKey+keyEpsilon) // data point is still within same pixel, so skip it and expand value span of this cluster if necessary
-      {
-        if (it->value < minValue)
-          minValue = it->value;
-        else if (it->value > maxValue)
-          maxValue = it->value;
-        ++intervalDataCount;
-      } else // new pixel interval started
-      {
-        if (intervalDataCount >= 2) // last pixel had multiple data points, consolidate them to a cluster
-        {
-          if (lastIntervalEndKey < currentIntervalStartKey-keyEpsilon) // last point is further away, so first point of this cluster must be at a real data point
-            lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.2, currentIntervalFirstPoint->value));
-          lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.25, minValue));
-          lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.75, maxValue));
-          if (it->key > currentIntervalStartKey+keyEpsilon*2) // new pixel started further away from previous cluster, so make sure the last point of the cluster is at a real data point
-            lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.8, (it-1)->value));
-        } else
-          lineData->append(QCPGraphData(currentIntervalFirstPoint->key, currentIntervalFirstPoint->value));
-        lastIntervalEndKey = (it-1)->key;
-        minValue = it->value;
-        maxValue = it->value;
-        currentIntervalFirstPoint = it;
-        currentIntervalStartKey = keyAxis->pixelToCoord((int)(keyAxis->coordToPixel(it->key)+reversedRound));
-        if (keyEpsilonVariable)
-          keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+1.0*reversedFactor));
-        intervalDataCount = 1;
-      }
+      lineData->append(*it);
       ++it;
     }
-    // handle last interval:
-    if (intervalDataCount >= 2) // last pixel had multiple data points, consolidate them to a cluster
-    {
-      if (lastIntervalEndKey < currentIntervalStartKey-keyEpsilon) // last point wasn't a cluster, so first point of this cluster must be at a real data point
-        lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.2, currentIntervalFirstPoint->value));
+  }
+}
+
+/*! \internal
+
+  Performs the adaptive sampling of \ref getOptimizedLineData with the help of the value pyramid
+  (see \ref setAdaptiveSamplingIndex). The pixel intervals are the same as in the linear algorithm,
+  but the end of each interval is found by binary search over the keys, and its value range is
+  taken from the pyramid. This produces exactly the same \a lineData as the linear algorithm.
+*/
+void QCPGraph::getIndexedLineData(QVector<QCPGraphData> *lineData, const QCPGraphDataContainer::const_iterator &begin, const QCPGraphDataContainer::const_iterator &end) const
+{
+  QCPAxis *keyAxis = mKeyAxis.data();
+  updateValuePyramid();
+  
+  const QCPGraphDataContainer::const_iterator dataBegin = mDataContainer->constBegin();
+  QCPGraphDataContainer::const_iterator it = begin;
+  int reversedFactor = keyAxis->pixelOrientation(); // is used to calculate keyEpsilon pixel into the correct direction
+  int reversedRound = reversedFactor==-1 ? 1 : 0; // is used to switch between floor (normal) and ceil (reversed) rounding of currentIntervalStartKey
+  double currentIntervalStartKey = keyAxis->pixelToCoord((int)(keyAxis->coordToPixel(begin->key)+reversedRound));
+  double lastIntervalEndKey = currentIntervalStartKey;
+  double keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+1.0*reversedFactor)); // interval of one pixel on screen when mapped to plot key coordinates
+  bool keyEpsilonVariable = keyAxis->scaleType() == QCPAxis::stLogarithmic; // indicates whether keyEpsilon needs to be updated after every interval (for log axes)
+  while (it != end)
+  {
+    // all points with keys below the end of the current pixel interval belong to it:
+    QCPGraphDataContainer::const_iterator intervalEnd = std::lower_bound(it+1, end, QCPGraphData::fromSortKey(currentIntervalStartKey+keyEpsilon), qcpLessThanSortKey<QCPGraphData>);
+    if (intervalEnd-it >= 2) // pixel has multiple data points, consolidate them to a cluster
+    {
+      // like the linear algorithm, a NaN first value makes the cluster range NaN:
+      double minValue = it->value;
+      double maxValue = it->value;
+      if (!qIsNaN(it->value))
+      {
+        QCPRange bounds = mValuePyramid.valueBounds(*mDataContainer, it+1-dataBegin, intervalEnd-dataBegin);
+        if (bounds.lower < minValue)
+          minValue = bounds.lower;
+        if (bounds.upper > maxValue)
+          maxValue = bounds.upper;
+      }
+      if (lastIntervalEndKey < currentIntervalStartKey-keyEpsilon) // last point is further away, so first point of this cluster must be at a real data point
+        lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.2, it->value));
       lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.25, minValue));
       lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.75, maxValue));
+      if (intervalEnd != end && intervalEnd->key > currentIntervalStartKey+keyEpsilon*2) // new pixel started further away from previous cluster, so make sure the last point of the cluster is at a real data point
+        lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.8, (intervalEnd-1)->value));
     } else
-      lineData->append(QCPGraphData(currentIntervalFirstPoint->key, currentIntervalFirstPoint->value));
-    
-  } else // don't use adaptive sampling algorithm, transfer points one-to-one from the data container into the output
+      lineData->append(QCPGraphData(it->key, it->value));
+    if (intervalEnd == end)
+      break;
+    lastIntervalEndKey = (intervalEnd-1)->key;
+    it = intervalEnd;
+    currentIntervalStartKey = keyAxis->pixelToCoord((int)(keyAxis->coordToPixel(it->key)+reversedRound));
+    if (keyEpsilonVariable)
+      keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+1.0*reversedFactor));
+  }
+}
+
+/*! \internal
+
+  The adaptive sampling algorithm of \ref getOptimizedLineData. Appends to \a lineData the points
+  that represent the pixel intervals of the data from \a begin to \a end. \a begin must be the first
+  point of a pixel interval, and \a end either the first point of another one or \a dataEnd, the
+  end of the sampled data, where the last interval is closed without looking at further points.
+
+  \a lastIntervalEndKey is the key of the point before \a begin (or the start key of the first
+  interval if there is none) and \a keyEpsilon the key span of one pixel at the first interval.
+*/
+void QCPGraph::getSampledLineData(QVector<QCPGraphData> *lineData, QCPGraphDataContainer::const_iterator begin, const QCPGraphDataContainer::const_iterator &end, const QCPGraphDataContainer::const_iterator &dataEnd, double lastIntervalEndKey, double keyEpsilon) const
+{
+  QCPAxis *keyAxis = mKeyAxis.data();
+  int reversedFactor = keyAxis->pixelOrientation(); // is used to calculate keyEpsilon pixel into the correct direction
+  int reversedRound = reversedFactor==-1 ? 1 : 0; // is used to switch between floor (normal) and ceil (reversed) rounding of currentIntervalStartKey
+  bool keyEpsilonVariable = keyAxis->scaleType() == QCPAxis::stLogarithmic; // indicates whether keyEpsilon needs to be updated after every interval (for log axes)
+  while (begin != end)
   {
-    QCPGraphDataContainer::const_iterator it = begin;
-    lineData->reserve(dataCount+2); // +2 for possible fill end points
-    while (it != end)
+    double currentIntervalStartKey = keyAxis->pixelToCoord((int)(keyAxis->coordToPixel(begin->key)+reversedRound));
+    if (keyEpsilonVariable)
+      keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+1.0*reversedFactor));
+    // find the first point beyond the pixel with a galloping search, so dense pixels don't compare every key:
+    const QCPGraphData intervalEndKey = QCPGraphData::fromSortKey(currentIntervalStartKey+keyEpsilon);
+    QCPGraphDataContainer::const_iterator searchBegin = begin+1;
+    QCPGraphDataContainer::const_iterator searchEnd = begin+1;
+    int step = 1;
+    while (searchEnd != end && qcpLessThanSortKey<QCPGraphData>(*searchEnd, intervalEndKey)) // data point is still within same pixel
+    {
+      searchBegin = searchEnd+1;
+      searchEnd = end-searchBegin > step ? searchBegin+step : end;
+      step *= 2;
+    }
+    QCPGraphDataContainer::const_iterator intervalEnd = std::lower_bound(searchBegin, searchEnd, intervalEndKey, qcpLessThanSortKey<QCPGraphData>);
+    if (intervalEnd-begin >= 2) // pixel had multiple data points, consolidate them to a cluster
+    {
+      double minValue = begin->value;
+      double maxValue = begin->value;
+      getValueRange(begin+1, intervalEnd, minValue, maxValue);
+      if (lastIntervalEndKey < currentIntervalStartKey-keyEpsilon) // last point is further away, so first point of this cluster must be at a real data point
+        lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.2, begin->value));
+      lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.25, minValue));
+      lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.75, maxValue));
+      if (intervalEnd != dataEnd && intervalEnd->key > currentIntervalStartKey+keyEpsilon*2) // new pixel started further away from previous cluster, so make sure the last point of the cluster is at a real data point
+        lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.8, (intervalEnd-1)->value));
+    } else
+      lineData->append(QCPGraphData(begin->key, begin->value));
+    lastIntervalEndKey = (intervalEnd-1)->key;
+    begin = intervalEnd;
+  }
+}
+
+#ifdef QCP_CONCURRENT
+/*! \internal
+
+  Performs \ref getSampledLineData on the data from \a begin to \a end in parallel. The data is
+  split into chunks of at least 65536 points, each of which starts at a point that certainly opens
+  a new pixel interval of the sequential algorithm. The chunks are sampled on the global thread
+  pool and their points concatenated, so \a lineData is the same as with a sequential run.
+*/
+void QCPGraph::getParallelSampledLineData(QVector<QCPGraphData> *lineData, const QCPGraphDataContainer::const_iterator &begin, const QCPGraphDataContainer::const_iterator &end, double lastIntervalEndKey, double keyEpsilon) const
+{
+  const int minimumChunkSize = 65536;
+  const int chunkCount = qMin(QThread::idealThreadCount()*4, int((end-begin)/minimumChunkSize));
+  if (chunkCount < 2)
+  {
+    getSampledLineData(lineData, begin, end, end, lastIntervalEndKey, keyEpsilon);
+    return;
+  }
+  
+  QCPAxis *keyAxis = mKeyAxis.data();
+  int reversedFactor = keyAxis->pixelOrientation();
+  int reversedRound = reversedFactor==-1 ? 1 : 0;
+  bool keyEpsilonVariable = keyAxis->scaleType() == QCPAxis::stLogarithmic;
+  QVector<LineSamplingChunk> chunks;
+  QCPGraphDataContainer::const_iterator chunkBegin = begin;
+  for (int i=1; i<=chunkCount && chunkBegin != end; ++i)
+  {
+    QCPGraphDataContainer::const_iterator split = begin+(end-begin)/chunkCount*i;
+    if (i == chunkCount)
+      split = end;
+    if (split <= chunkBegin)
+      continue;
+    // move the split point forward until it lies beyond the pixel interval of its predecessor. Any
+    // interval containing the predecessor ends no later than that, so the split point opens a new one:
+    while (split != end)
     {
-      lineData->append(*it);
-      ++it;
+      double intervalStartKey = keyAxis->pixelToCoord((int)(keyAxis->coordToPixel((split-1)->key)+reversedRound));
+      double intervalEndKey = intervalStartKey + (keyEpsilonVariable ? qAbs(intervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(intervalStartKey)+1.0*reversedFactor)) : keyEpsilon);
+      if (!(split->key < intervalEndKey))
+        break;
+      split = std::lower_bound(split, end, QCPGraphData::fromSortKey(intervalEndKey), qcpLessThanSortKey<QCPGraphData>);
+    }
+    LineSamplingChunk chunk;
+    chunk.graph = this;
+    chunk.begin = chunkBegin;
+    chunk.end = split;
+    chunk.dataEnd = end;
+    chunk.lastIntervalEndKey = chunkBegin == begin ? lastIntervalEndKey : (chunkBegin-1)->key;
+    chunk.keyEpsilon = keyEpsilon;
+    chunks.append(chunk);
+    chunkBegin = split;
+  }
+  
+  QtConcurrent::blockingMap(chunks, &LineSamplingChunk::sample);
+  
+  int count = lineData->size();
+  for (int i=0; i<chunks.size(); ++i)
+    count += chunks.at(i).lineData.size();
+  lineData->reserve(count);
+  for (int i=0; i<chunks.size(); ++i)
+    *lineData += chunks.at(i).lineData;
+}
+#endif
+
+/*! \internal
+
+  Extends \a minValue and \a maxValue to the values of the data points from \a begin to \a end.
+  NaN values are ignored, unless \a minValue and \a maxValue are NaN already, in which case they
+  stay NaN. This matches the point by point comparisons of the adaptive sampling algorithm.
+
+  With SSE2, two values are compared per instruction.
+*/
+void QCPGraph::getValueRange(QCPGraphDataContainer::const_iterator begin, const QCPGraphDataContainer::const_iterator &end, double &minValue, double &maxValue) const
+{
+#ifdef QCP_SSE2
+  if (end-begin >= 4)
+  {
+    // a QCPGraphData is a key and a value, so the values of two points are the upper halves of two loads:
+    __m128d minLanes = _mm_set1_pd(minValue);
+    __m128d maxLanes = _mm_set1_pd(maxValue);
+    for (; end-begin >= 2; begin += 2)
+    {
+      __m128d values = _mm_unpackhi_pd(_mm_loadu_pd(&begin->key), _mm_loadu_pd(&(begin+1)->key));
+      minLanes = _mm_min_pd(values, minLanes); // returns the second operand if either is NaN
+      maxLanes = _mm_max_pd(values, maxLanes);
     }
+    double lanes[2];
+    _mm_storeu_pd(lanes, minLanes);
+    if (lanes[0] < minValue) minValue = lanes[0];
+    if (lanes[1] < minValue) minValue = lanes[1];
+    _mm_storeu_pd(lanes, maxLanes);
+    if (lanes[0] > maxValue) maxValue = lanes[0];
+    if (lanes[1] > maxValue) maxValue = lanes[1];
   }
+#endif
+  for (; begin != end; ++begin)
+  {
+    if (begin->value < minValue)
+      minValue = begin->value;
+    else if (begin->value > maxValue)
+      maxValue = begin->value;
+  }
+}
+
+/*! \internal
+
+  Makes sure the value pyramid matches the current data, which may have been modified directly via
+  \ref data since the last \ref setData or \ref addData call.
+*/
+void QCPGraph::updateValuePyramid() const
+{
+  mValuePyramid.update(*mDataContainer);
 }
 
 /*! \internal
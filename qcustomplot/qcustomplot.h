@@ -44,6 +44,14 @@
   #define QCP_DEVICEPIXELRATIO_SUPPORTED
 #endif
 
+#if defined(QCUSTOMPLOT_USE_CONCURRENT) && QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+#  define QCP_CONCURRENT
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define QCP_SSE2
+#endif
+
 #include <QtCore/QObject>
 #include <QtCore/QPointer>
 #include <QtCore/QSharedPointer>
@@ -87,6 +95,13 @@
 #  include <QtWidgets/QWidget>
 #  include <QtPrintSupport/QtPrintSupport>
 #endif
+#ifdef QCP_CONCURRENT
+#  include <QtCore/QThread>
+#  include <QtConcurrent/QtConcurrentMap>
+#endif
+#ifdef QCP_SSE2
+#  include <emmintrin.h>
+#endif
 
 class QCPPainter;
 class QCustomPlot;
@@ -564,6 +579,29 @@ protected:
 };
 
 
+class QCP_LIB_DECL QCPPaintBufferImage : public QCPAbstractPaintBuffer
+{
+public:
+  explicit QCPPaintBufferImage(const QSize &size, double devicePixelRatio);
+  virtual ~QCPPaintBufferImage();
+  
+  // getters:
+  const QImage &image() const { return mBuffer; }
+  
+  // reimplemented virtual methods:
+  virtual QCPPainter *startPainting() Q_DECL_OVERRIDE;
+  virtual void draw(QCPPainter *painter) const Q_DECL_OVERRIDE;
+  void clear(const QColor &color) Q_DECL_OVERRIDE;
+  
+protected:
+  // non-property members:
+  QImage mBuffer;
+  
+  // reimplemented virtual methods:
+  virtual void reallocateBuffer() Q_DECL_OVERRIDE;
+};
+
+
 #ifdef QCP_OPENGL_PBUFFER
 class QCP_LIB_DECL QCPPaintBufferGlPbuffer : public QCPAbstractPaintBuffer
 {
@@ -3562,6 +3600,8 @@ class QCP_LIB_DECL QCustomPlot : public QWidget
   Q_PROPERTY(bool noAntialiasingOnDrag READ noAntialiasingOnDrag WRITE setNoAntialiasingOnDrag)
   Q_PROPERTY(Qt::KeyboardModifier multiSelectModifier READ multiSelectModifier WRITE setMultiSelectModifier)
   Q_PROPERTY(bool openGl READ openGl WRITE setOpenGl)
+  Q_PROPERTY(bool threadedReplot READ threadedReplot WRITE setThreadedReplot)
+  Q_PROPERTY(RasterBuffer rasterBuffer READ rasterBuffer WRITE setRasterBuffer)
   /// \endcond
 public:
   /*!
@@ -3586,6 +3626,16 @@ public:
                        };
   Q_ENUMS(RefreshPriority)
   
+  /*!
+    Defines which paint buffers are used for software rendering, i.e. when \ref setOpenGl is false.
+
+    \see setRasterBuffer
+  */
+  enum RasterBuffer { rbPixmap ///< Paint buffers are QPixmaps (\ref QCPPaintBufferPixmap), which may be stored by the windowing system
+                      ,rbImage ///< Paint buffers are QImages (\ref QCPPaintBufferImage) in client memory, which can be painted from any thread
+                    };
+  Q_ENUMS(RasterBuffer)
+  
   explicit QCustomPlot(QWidget *parent = 0);
   virtual ~QCustomPlot();
   
@@ -3607,6 +3657,8 @@ public:
   QCP::SelectionRectMode selectionRectMode() const { return mSelectionRectMode; }
   QCPSelectionRect *selectionRect() const { return mSelectionRect; }
   bool openGl() const { return mOpenGl; }
+  bool threadedReplot() const { return mThreadedReplot; }
+  RasterBuffer rasterBuffer() const { return mRasterBuffer; }
   
   // setters:
   void setViewport(const QRect &rect);
@@ -3631,6 +3683,8 @@ public:
   void setSelectionRectMode(QCP::SelectionRectMode mode);
   void setSelectionRect(QCPSelectionRect *selectionRect);
   void setOpenGl(bool enabled, int multisampling=16);
+  void setThreadedReplot(bool enabled);
+  void setRasterBuffer(RasterBuffer type);
   
   // non-property methods:
   // plottable interface:
@@ -3745,6 +3799,8 @@ protected:
   QCP::SelectionRectMode mSelectionRectMode;
   QCPSelectionRect *mSelectionRect;
   bool mOpenGl;
+  bool mThreadedReplot;
+  RasterBuffer mRasterBuffer;
   
   // non-property members:
   QList<QSharedPointer<QCPAbstractPaintBuffer> > mPaintBuffers;
@@ -3794,6 +3850,10 @@ protected:
   void setupPaintBuffers();
   QCPAbstractPaintBuffer *createPaintBuffer();
   bool hasInvalidatedPaintBuffers();
+  void drawToPaintBuffersConcurrently();
+#ifdef QCP_CONCURRENT
+  static void drawLayerGroup(QList<QCPLayer*> &layers);
+#endif
   bool setupOpenGl();
   void freeOpenGl();
   
@@ -3807,6 +3867,7 @@ protected:
 };
 Q_DECLARE_METATYPE(QCustomPlot::LayerInsertMode)
 Q_DECLARE_METATYPE(QCustomPlot::RefreshPriority)
+Q_DECLARE_METATYPE(QCustomPlot::RasterBuffer)
 
 /* end of 'src/core.h' */
 
@@ -5116,6 +5177,34 @@ Q_DECLARE_TYPEINFO(QCPGraphData, Q_PRIMITIVE_TYPE);
 */
 typedef QCPDataContainer<QCPGraphData> QCPGraphDataContainer;
 
+class QCP_LIB_DECL QCPGraphValuePyramid
+{
+public:
+  QCPGraphValuePyramid();
+  
+  // getters:
+  bool isEmpty() const { return mLevels.isEmpty(); }
+  bool isValidFor(const QCPGraphDataContainer &data) const;
+  
+  // non-virtual methods:
+  void build(const QCPGraphDataContainer &data);
+  void update(const QCPGraphDataContainer &data);
+  void clear();
+  QCPRange valueBounds(const QCPGraphDataContainer &data, int begin, int end) const;
+  
+protected:
+  enum { BlockSize = 64 }; ///< number of data points summarized by one entry of the lowest level
+  
+  // non-property members:
+  QVector<QVector<QCPRange> > mLevels;
+  int mCount;
+  double mFirstKey, mLastKey;
+  double mFirstValue, mLastValue;
+  
+  // non-virtual methods:
+  void rebuildFrom(const QCPGraphDataContainer &data, int firstBlock);
+};
+
 class QCP_LIB_DECL QCPGraph : public QCPAbstractPlottable1D<QCPGraphData>
 {
   Q_OBJECT
@@ -5125,6 +5214,7 @@ class QCP_LIB_DECL QCPGraph : public QCPAbstractPlottable1D<QCPGraphData>
   Q_PROPERTY(int scatterSkip READ scatterSkip WRITE setScatterSkip)
   Q_PROPERTY(QCPGraph* channelFillGraph READ channelFillGraph WRITE setChannelFillGraph)
   Q_PROPERTY(bool adaptiveSampling READ adaptiveSampling WRITE setAdaptiveSampling)
+  Q_PROPERTY(bool adaptiveSamplingIndex READ adaptiveSamplingIndex WRITE setAdaptiveSamplingIndex)
   /// \endcond
 public:
   /*!
@@ -5152,6 +5242,7 @@ public:
   int scatterSkip() const { return mScatterSkip; }
   QCPGraph *channelFillGraph() const { return mChannelFillGraph.data(); }
   bool adaptiveSampling() const { return mAdaptiveSampling; }
+  bool adaptiveSamplingIndex() const { return mAdaptiveSamplingIndex; }
   
   // setters:
   void setData(QSharedPointer<QCPGraphDataContainer> data);
@@ -5161,6 +5252,7 @@ public:
   void setScatterSkip(int skip);
   void setChannelFillGraph(QCPGraph *targetGraph);
   void setAdaptiveSampling(bool enabled);
+  void setAdaptiveSamplingIndex(bool enabled);
   
   // non-property methods:
   void addData(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted=false);
@@ -5178,6 +5270,21 @@ protected:
   int mScatterSkip;
   QPointer<QCPGraph> mChannelFillGraph;
   bool mAdaptiveSampling;
+  bool mAdaptiveSamplingIndex;
+  
+  // non-property members:
+  mutable QCPGraphValuePyramid mValuePyramid;
+  
+#ifdef QCP_CONCURRENT
+  struct LineSamplingChunk
+  {
+    const QCPGraph *graph;
+    QCPGraphDataContainer::const_iterator begin, end, dataEnd;
+    double lastIntervalEndKey, keyEpsilon;
+    QVector<QCPGraphData> lineData;
+    void sample() { graph->getSampledLineData(&lineData, begin, end, dataEnd, lastIntervalEndKey, keyEpsilon); }
+  };
+#endif
   
   // reimplemented virtual methods:
   virtual void draw(QCPPainter *painter) Q_DECL_OVERRIDE;
@@ -5193,6 +5300,13 @@ protected:
   virtual void getOptimizedScatterData(QVector<QCPGraphData> *scatterData, QCPGraphDataContainer::const_iterator begin, QCPGraphDataContainer::const_iterator end) const;
   
   // non-virtual methods:
+  void getIndexedLineData(QVector<QCPGraphData> *lineData, const QCPGraphDataContainer::const_iterator &begin, const QCPGraphDataContainer::const_iterator &end) const;
+  void getSampledLineData(QVector<QCPGraphData> *lineData, QCPGraphDataContainer::const_iterator begin, const QCPGraphDataContainer::const_iterator &end, const QCPGraphDataContainer::const_iterator &dataEnd, double lastIntervalEndKey, double keyEpsilon) const;
+#ifdef QCP_CONCURRENT
+  void getParallelSampledLineData(QVector<QCPGraphData> *lineData, const QCPGraphDataContainer::const_iterator &begin, const QCPGraphDataContainer::const_iterator &end, double lastIntervalEndKey, double keyEpsilon) const;
+#endif
+  void getValueRange(QCPGraphDataContainer::const_iterator begin, const QCPGraphDataContainer::const_iterator &end, double &minValue, double &maxValue) const;
+  void updateValuePyramid() const;
   void getVisibleDataBounds(QCPGraphDataContainer::const_iterator &begin, QCPGraphDataContainer::const_iterator &end, const QCPDataRange &rangeRestriction) const;
   void getLines(QVector<QPointF> *lines, const QCPDataRange &dataRange) const;
   void getScatters(QVector<QPointF> *scatters, const QCPDataRange &dataRange) const;
@@ -0,0 +1,129 @@
+#include "batchhistogram.h"
+#include "histogram.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+// QVector sizes are ints, and the allocation in bytes has to fit too
+const qint64 maxBatchValues = std::numeric_limits<int>::max() / static_cast<int>(sizeof(double));
+
+}
+
+const double* HistogramBatch::row(int signal) const {
+    return probability.constData() + static_cast<long long>(signal) * stride;
+}
+
+QVector<double> HistogramBatch::xAxis(int signal) const {
+    QVector<double> axis(bins[signal]);
+
+    for (int i = 0; i < bins[signal]; ++i) {
+        axis[i] = (firstKey[signal] + i) * binWidth[signal];
+    }
+
+    return axis;
+}
+
+HistogramBatch batchHistograms(const QVector<SampleView>& signalsToBin, double bins, QString* error) {
+    HistogramBatch batch;
+    int count = signalsToBin.size();
+
+    batch.signalCount = count;
+    batch.stride = 0;
+    batch.min.resize(count);
+    batch.max.resize(count);
+    batch.binWidth.resize(count);
+    batch.firstKey.resize(count);
+    batch.bins.resize(count);
+    batch.entropy.resize(count);
+
+    int workers = parallelWorkerCount();
+
+    // workers only write through these pointers, the vectors must not be touched (detach checks)
+    double* min = batch.min.data();
+    double* max = batch.max.data();
+    double* binWidth = batch.binWidth.data();
+    double* firstKey = batch.firstKey.data();
+    int* binCount = batch.bins.data();
+    double* entropy = batch.entropy.data();
+
+    // the layouts come first: the row stride is the largest bin count of all signals
+    parallelForStealing(count, workers, [&](int, long long i) {
+        const SampleView& view = signalsToBin[i];
+        double low = 0;
+        double high = 0;
+
+        if (view.size > 0) {
+            visitSamples(view, [&](auto data) {
+                auto minmax = std::minmax_element(data, data + view.size);
+                low = *(minmax.first);
+                high = *(minmax.second);
+            });
+        }
+
+        HistogramLayout layout = histogramLayout(low, high, bins, view.size);
+
+        min[i] = low;
+        max[i] = high;
+        binWidth[i] = layout.binWidth;
+        firstKey[i] = layout.firstKey;
+        binCount[i] = layout.size;
+    });
+
+    for (int i = 0; i < count; ++i) {
+        batch.stride = std::max(batch.stride, batch.bins[i]);
+    }
+
+    qint64 values = static_cast<qint64>(count) * batch.stride;
+
+    if (values > maxBatchValues) {
+        if (error) {
+            *error = QString("%1 histograms of %2 bins do not fit into one batch").arg(count).arg(batch.stride);
+        }
+        return HistogramBatch();
+    }
+
+    batch.probability.fill(0, static_cast<int>(values));
+    double* probability = batch.probability.data();
+
+    // each worker counts into its own buffer, which is reused for every signal it takes
+    std::vector<QVector<qint64>> counts(workers, QVector<qint64>(batch.stride));
+
+    parallelForStealing(count, workers, [&](int worker, long long i) {
+        const SampleView& view = signalsToBin[i];
+        HistogramLayout layout;
+        layout.binWidth = binWidth[i];
+        layout.firstKey = firstKey[i];
+        layout.size = binCount[i];
+
+        qint64* binCounts = counts[worker].data();
+        double* row = probability + i * batch.stride;
+
+        std::fill(binCounts, binCounts + layout.size, 0);
+
+        visitSamples(view, [&](auto data) {
+            histogramAccumulate(data, view.size, layout, binCounts);
+        });
+
+        for (int bin = 0; bin < layout.size; ++bin) {
+            row[bin] = static_cast<double>(binCounts[bin]) / view.size;
+        }
+
+        entropy[i] = histogramEntropy(row, layout.size);
+    });
+
+    return batch;
+}
+
+HistogramBatch batchHistograms(const double* samples, int signalCount, int length, double bins,
+                               QString* error) {
+    QVector<SampleView> views(std::max(signalCount, 0));
+
+    for (int i = 0; i < views.size(); ++i) {
+        views[i] = {samples + static_cast<long long>(i) * length, length, Float64Format};
+    }
+
+    return batchHistograms(views, bins, error);
+}
@@ -0,0 +1,394 @@
+#include "chunkedsignal.h"
+#include "dsp1_signal.h"
+#include "signalfile.h"
+#include "histogram.h"
+#include "parallel.h"
+#include "streamconvolver.h"
+
+#include <QFile>
+#include <QMutex>
+#include <QSysInfo>
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+bool fail(QString* error, const QString& message) {
+    if (error) {
+        *error = message;
+    }
+    return false;
+}
+
+}
+
+struct ChunkedSignalFile {
+    QFile file;
+    // QFile is not reentrant, every map, unmap and read goes through this lock
+    QMutex mutex;
+    SignalFileHeader header;
+};
+
+SignalPage::SignalPage() : first(0) {
+    view.data = 0;
+    view.size = 0;
+    view.format = Float64Format;
+}
+
+SampleView SignalPage::getView() const {
+    return view;
+}
+
+qint64 SignalPage::getFirst() const {
+    return first;
+}
+
+ChunkedSignal::ChunkedSignal(int pageSize) :
+    pageSize(std::max(pageSize, 1)), statistics(), statisticsValid(false) {
+}
+
+bool ChunkedSignal::open(const QString& fileName, QString* error) {
+    std::shared_ptr<ChunkedSignalFile> opened(new ChunkedSignalFile());
+
+    opened->file.setFileName(fileName);
+
+    if (!opened->file.open(QIODevice::ReadOnly)) {
+        if (error) {
+            *error = QString("cannot open %1").arg(fileName);
+        }
+        return false;
+    }
+
+    if (!readSignalFileHeader(opened->file, opened->header, error)) {
+        return false;
+    }
+
+    file = opened;
+    histogramXAxis.clear();
+    histogramYAxis.clear();
+    statisticsValid = false;
+
+    return true;
+}
+
+SignalPage ChunkedSignal::getPage(qint64 index, QString* error) const {
+    return getRange(index * pageSize, pageSize, error);
+}
+
+SignalPage ChunkedSignal::getRange(qint64 first, int count, QString* error) const {
+    SignalPage page;
+    page.first = first;
+    page.view.format = getFormat();
+
+    if (!file || first < 0 || first >= getSize() || count <= 0) {
+        return page;
+    }
+
+    count = static_cast<int>(std::min<qint64>(count, getSize() - first));
+
+    int sampleSize = sampleFormatSize(page.view.format);
+    qint64 offset = file->header.dataOffset + first * sampleSize;
+    qint64 bytes = static_cast<qint64>(count) * sampleSize;
+    std::shared_ptr<ChunkedSignalFile> source = file;
+    uchar* mapping = 0;
+
+    if (QSysInfo::ByteOrder == QSysInfo::LittleEndian) {
+        QMutexLocker locker(&source->mutex);
+        mapping = source->file.map(offset, bytes);
+    }
+
+    if (mapping) {
+        page.storage = std::shared_ptr<const void>(mapping, [source](const void* data) {
+            QMutexLocker locker(&source->mutex);
+            source->file.unmap(static_cast<uchar*>(const_cast<void*>(data)));
+        });
+    }
+    else {
+        // no mmap support for this file (or a big-endian host), the page is read instead
+        std::shared_ptr<quint64> buffer(new quint64[(bytes + 7) / 8], std::default_delete<quint64[]>());
+        bool complete;
+
+        {
+            QMutexLocker locker(&source->mutex);
+            complete = source->file.seek(offset)
+                && source->file.read(reinterpret_cast<char*>(buffer.get()), bytes) == bytes;
+        }
+
+        if (!complete) {
+            fail(error, QString("cannot read samples %1 to %2 of %3")
+                 .arg(first).arg(first + count - 1).arg(source->file.fileName()));
+            return page;
+        }
+
+        signalFileToHostOrder(buffer.get(), count, page.view.format);
+        page.storage = buffer;
+    }
+
+    page.view.data = page.storage.get();
+    page.view.size = count;
+
+    return page;
+}
+
+qint64 ChunkedSignal::getPageCount() const {
+    return (getSize() + pageSize - 1) / pageSize;
+}
+
+int ChunkedSignal::getPageSize() const {
+    return pageSize;
+}
+
+qint64 ChunkedSignal::getSize() const {
+    return file ? static_cast<qint64>(file->header.sampleCount) : 0;
+}
+
+SampleFormat ChunkedSignal::getFormat() const {
+    return file ? file->header.sampleType : Float64Format;
+}
+
+// Runs task(worker, index, page) for every page on the work-stealing pool,
+// at most one page per worker is mapped at a time. Pages that cannot be read are
+// skipped and reported through error, the first one in page order.
+template<typename Task>
+bool ChunkedSignal::forEachPage(Task task, QString* error) const {
+    std::vector<QString> pageErrors(getPageCount());
+
+    parallelForStealing(getPageCount(), parallelWorkerCount(), [&](int worker, long long index) {
+        SignalPage page = getPage(index, &pageErrors[index]);
+
+        if (pageErrors[index].isEmpty()) {
+            task(worker, index, page);
+        }
+    });
+
+    for (const QString& pageError : pageErrors) {
+        if (!pageError.isEmpty()) {
+            return fail(error, pageError);
+        }
+    }
+
+    return true;
+}
+
+bool ChunkedSignal::computeStatistics(QString* error) const {
+    if (statisticsValid) {
+        return true;
+    }
+
+    // one accumulator per page, merged in page order so the result does not depend on scheduling
+    std::vector<MomentAccumulator> pages(getPageCount());
+
+    bool read = forEachPage([&](int, qint64 index, const SignalPage& page) {
+        SampleView view = page.getView();
+
+        visitSamples(view, [&](auto data) {
+            accumulateMoments(data, view.size, pages[index]);
+        });
+    }, error);
+
+    if (!read) {
+        statistics = SignalStatistics();
+        return false;
+    }
+
+    MomentAccumulator total;
+
+    for (const MomentAccumulator& page : pages) {
+        total.merge(page);
+    }
+
+    statistics = total.statistics();
+    statisticsValid = true;
+
+    return true;
+}
+
+const SignalStatistics& ChunkedSignal::getStatistics(QString* error) const {
+    computeStatistics(error);
+
+    return statistics;
+}
+
+double ChunkedSignal::getSum(QString* error) const {
+    if (!computeStatistics(error)) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+
+    return statistics.mean * statistics.count;
+}
+
+double ChunkedSignal::getMin(QString* error) const {
+    if (!computeStatistics(error)) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+
+    return statistics.min;
+}
+
+double ChunkedSignal::getMax(QString* error) const {
+    if (!computeStatistics(error)) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+
+    return statistics.max;
+}
+
+bool ChunkedSignal::setHistogram(double bins, QString* error) {
+    if (!computeStatistics(error)) {
+        return false;
+    }
+
+    HistogramLayout layout = histogramLayout(getMin(), getMax(), bins, getSize());
+    std::vector<QVector<qint64>> partial(parallelWorkerCount(), QVector<qint64>(layout.size, 0));
+
+    if (layout.size > 0) {
+        bool read = forEachPage([&](int worker, qint64, const SignalPage& page) {
+            SampleView view = page.getView();
+
+            visitSamples(view, [&](auto data) {
+                histogramAccumulate(data, view.size, layout, partial[worker].data());
+            });
+        }, error);
+
+        if (!read) {
+            return false;
+        }
+    }
+
+    histogramXAxis.resize(layout.size);
+    histogramYAxis.resize(layout.size);
+
+    for (int i = 0; i < layout.size; ++i) {
+        qint64 count = 0;
+
+        for (const auto& counts : partial) {
+            count += counts[i];
+        }
+
+        histogramXAxis[i] = (layout.firstKey + i) * layout.binWidth;
+        histogramYAxis[i] = static_cast<double>(count) / getSize();
+    }
+
+    return true;
+}
+
+const QVector<double>& ChunkedSignal::getHistogramXAxis() const {
+    return histogramXAxis;
+}
+
+const QVector<double>& ChunkedSignal::getHistogramYAxis() const {
+    return histogramYAxis;
+}
+
+double ChunkedSignal::getEntropy() const {
+    return histogramEntropy(histogramYAxis);
+}
+
+bool ChunkedSignal::writeSum(const QVector<ChunkedSignal>& inputs, const QString& fileName,
+                             SampleFormat format, QString* error) {
+    SignalFileWriter writer;
+
+    if (!writer.open(fileName, format)) {
+        if (error) {
+            *error = QString("cannot write %1").arg(fileName);
+        }
+        return false;
+    }
+
+    qint64 size = 0;
+
+    for (int k = 0; k < inputs.size(); ++k) {
+        if (k == 0 || inputs[k].getSize() < size) {
+            size = inputs[k].getSize();
+        }
+    }
+
+    int blockSize = inputs.isEmpty() ? 1 : inputs[0].getPageSize();
+    Signal block;
+    block.setFormat(format);
+
+    // one page of every input is mapped at a time and summed by the fused Signal::setBySum
+    for (qint64 first = 0; first < size; first += blockSize) {
+        int count = static_cast<int>(std::min<qint64>(blockSize, size - first));
+        QVector<SignalPage> pages;
+        QVector<SampleView> views;
+
+        for (const ChunkedSignal& input : inputs) {
+            QString readError;
+
+            pages.push_back(input.getRange(first, count, &readError));
+            views.push_back(pages.back().getView());
+
+            if (!readError.isEmpty()) {
+                return fail(error, readError);
+            }
+        }
+
+        block.setBySum(views);
+
+        if (block.getSize() != static_cast<size_t>(count) || !writer.write(block.getView())) {
+            if (error) {
+                *error = QString("cannot sum into %1").arg(fileName);
+            }
+            return false;
+        }
+    }
+
+    if (!writer.close()) {
+        if (error) {
+            *error = QString("cannot write %1").arg(fileName);
+        }
+        return false;
+    }
+
+    return true;
+}
+
+bool ChunkedSignal::writeConvolution(const ChunkedSignal& input, const QVector<double>& kernel,
+                                     const QString& fileName, SampleFormat format, QString* error) {
+    SignalFileWriter writer;
+
+    if (!writer.open(fileName, format)) {
+        return fail(error, QString("cannot write %1").arg(fileName));
+    }
+
+    auto write = [&](const QVector<double>& samples) -> bool {
+        return samples.isEmpty() || writer.write({samples.constData(), samples.size(), Float64Format});
+    };
+
+    // an empty input or kernel has an empty convolution
+    if (input.getSize() > 0 && !kernel.isEmpty()) {
+        StreamConvolver convolver(kernel);
+        QVector<double> chunk;
+
+        for (qint64 index = 0; index < input.getPageCount(); ++index) {
+            QString readError;
+            SignalPage page = input.getPage(index, &readError);
+
+            if (!readError.isEmpty()) {
+                return fail(error, readError);
+            }
+
+            SampleView view = page.getView();
+            chunk.resize(view.size);
+
+            visitSamples(view, [&](auto data) {
+                std::copy(data, data + view.size, chunk.begin());
+            });
+
+            if (!write(convolver.process(chunk))) {
+                return fail(error, QString("cannot convolve into %1").arg(fileName));
+            }
+        }
+
+        if (!write(convolver.flush())) {
+            return fail(error, QString("cannot convolve into %1").arg(fileName));
+        }
+    }
+
+    if (!writer.close()) {
+        return fail(error, QString("cannot write %1").arg(fileName));
+    }
+
+    return true;
+}
@@ -0,0 +1,585 @@
+#include <QGuiApplication>
+#include <QScopedPointer>
+#include <QCommandLineParser>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QDir>
+#include <QTextStream>
+#include <functional>
+#include <type_traits>
+#include "signalpipeline.h"
+#include "parametersweep.h"
+#include "montecarlo.h"
+#include "signalio.h"
+#include "signalfile.h"
+#include "chunkedsignal.h"
+#include "plotrenderer.h"
+#include "constants.h"
+
+// Command-line batch runner: formula -> noise -> sum -> convolution -> histogram -> entropy
+// for one configuration given by options, or for every configuration of a JSON file.
+
+struct RunConfiguration {
+    QString name;
+    PipelineParameters parameters;
+};
+
+struct ParameterOption {
+    QString option;
+    QString key;
+    QString description;
+    std::function<bool(PipelineParameters&, const QString&)> set;
+};
+
+template<typename T>
+std::function<bool(PipelineParameters&, const QString&)> parameterSetter(T PipelineParameters::* field) {
+    return [field](PipelineParameters& parameters, const QString& text) -> bool {
+        bool ok = false;
+        T value;
+
+        if constexpr (std::is_same<T, int>::value) {
+            value = text.toInt(&ok);
+        }
+        else if constexpr (std::is_same<T, quint64>::value) {
+            value = text.toULongLong(&ok);
+        }
+        else {
+            value = text.toDouble(&ok);
+        }
+
+        if (ok) {
+            parameters.*field = value;
+        }
+
+        return ok;
+    };
+}
+
+const QVector<ParameterOption>& parameterOptions() {
+    static const QVector<ParameterOption> options {
+        {"signal-count", "signalCount", "Number of signal samples.", parameterSetter(&PipelineParameters::signalCount)},
+        {"signal-step", "signalStep", "Signal sampling step.", parameterSetter(&PipelineParameters::signalStep)},
+        {"signal-a", "signalA", "Signal variable 'a'.", parameterSetter(&PipelineParameters::signalA)},
+        {"signal-sigma", "signalSigma", "Signal variable 'sigma'.", parameterSetter(&PipelineParameters::signalSigma)},
+        {"signal-mu", "signalMu", "Signal variable 'mu'.", parameterSetter(&PipelineParameters::signalMu)},
+        {"noise-count", "noiseCount", "Number of noise samples.", parameterSetter(&PipelineParameters::noiseCount)},
+        {"noise-mean", "noiseMean", "Noise mean.", parameterSetter(&PipelineParameters::noiseMean)},
+        {"noise-sd", "noiseSD", "Noise standard deviation.", parameterSetter(&PipelineParameters::noiseSD)},
+        {"noise-seed", "noiseSeed", "Noise random seed.", parameterSetter(&PipelineParameters::noiseSeed)},
+        {"bins", "histogramBins", "Number of histogram bins.", parameterSetter(&PipelineParameters::histogramBins)}
+    };
+
+    return options;
+}
+
+PipelineParameters defaultParameters() {
+    PipelineParameters parameters;
+
+    parameters.signalCount = signalDefaultCount;
+    parameters.signalStep = signalDefaultStep;
+    parameters.signalA = signalDefaultA;
+    parameters.signalSigma = signalDefaultSigma;
+    parameters.signalMu = signalDefaultMu;
+
+    parameters.noiseCount = noiseDefaultCount;
+    parameters.noiseMean = noiseDefaultMean;
+    parameters.noiseSD = noiseDefaultSD;
+    parameters.noiseSeed = noiseDefaultSeed;
+
+    parameters.histogramBins = histogramDefaultBins;
+
+    return parameters;
+}
+
+bool parseConfiguration(const QJsonObject& object, RunConfiguration& configuration, QString& error) {
+    if (object.contains("name")) {
+        configuration.name = object.value("name").toString();
+    }
+
+    for (const ParameterOption& option : parameterOptions()) {
+        if (!object.contains(option.key)) {
+            continue;
+        }
+
+        QJsonValue value = object.value(option.key);
+        // numbers go through text so that 64-bit seeds can be given as strings
+        QString text = value.isString() ? value.toString() : QString::number(value.toDouble(), 'g', 17);
+
+        if (!option.set(configuration.parameters, text)) {
+            error = QString("invalid value of \"%1\" in %2").arg(option.key, configuration.name);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool loadConfigurations(const QString& fileName, const RunConfiguration& base,
+                        QVector<RunConfiguration>& configurations, QString& error) {
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = QString("cannot open %1").arg(fileName);
+        return false;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+
+    if (document.isNull()) {
+        error = QString("%1: %2").arg(fileName, parseError.errorString());
+        return false;
+    }
+
+    // either a single configuration or an array of them
+    QJsonArray runs = document.isArray() ? document.array() : QJsonArray({document.object()});
+
+    for (int i = 0; i < runs.size(); ++i) {
+        RunConfiguration configuration = base;
+        configuration.name = QString("run%1").arg(i + 1, 4, 10, QChar('0'));
+
+        if (!parseConfiguration(runs[i].toObject(), configuration, error)) {
+            return false;
+        }
+
+        configurations.push_back(configuration);
+    }
+
+    return true;
+}
+
+bool parseRange(const QJsonValue& value, SweepRange& range) {
+    if (value.isDouble()) {
+        range.from = range.to = value.toDouble();
+        range.steps = 1;
+        return true;
+    }
+
+    QJsonObject object = value.toObject();
+
+    if (!object.contains("from")) {
+        return false;
+    }
+
+    range.from = object.value("from").toDouble();
+    range.to = object.value("to").toDouble(range.from);
+    range.steps = object.value("steps").toInt(1);
+
+    return true;
+}
+
+// Sweep files hold {"from", "to", "steps"} objects (or plain numbers) for signalA, signalSigma,
+// signalMu, noiseMean and noiseSD; all other pipeline keys are fixed values
+bool loadSweep(const QString& fileName, const RunConfiguration& base, SweepParameters& sweep, QString& error) {
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = QString("cannot open %1").arg(fileName);
+        return false;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+
+    if (!document.isObject()) {
+        error = QString("%1: %2").arg(fileName, document.isNull() ? parseError.errorString() : "expected an object");
+        return false;
+    }
+
+    QJsonObject object = document.object();
+    const PipelineParameters& parameters = base.parameters;
+
+    sweep.signalA = {parameters.signalA, parameters.signalA, 1};
+    sweep.signalSigma = {parameters.signalSigma, parameters.signalSigma, 1};
+    sweep.signalMu = {parameters.signalMu, parameters.signalMu, 1};
+    sweep.noiseMean = {parameters.noiseMean, parameters.noiseMean, 1};
+    sweep.noiseSD = {parameters.noiseSD, parameters.noiseSD, 1};
+
+    QVector<QPair<QString, SweepRange*>> ranges {
+        {"signalA", &sweep.signalA},
+        {"signalSigma", &sweep.signalSigma},
+        {"signalMu", &sweep.signalMu},
+        {"noiseMean", &sweep.noiseMean},
+        {"noiseSD", &sweep.noiseSD}
+    };
+
+    for (const auto& range : ranges) {
+        if (object.contains(range.first) && !parseRange(object.value(range.first), *range.second)) {
+            error = QString("invalid range \"%1\" in %2").arg(range.first, fileName);
+            return false;
+        }
+        object.remove(range.first);
+    }
+
+    // the remaining keys are the fixed parameters
+    RunConfiguration fixed = base;
+    fixed.name = fileName;
+
+    if (!parseConfiguration(object, fixed, error)) {
+        return false;
+    }
+
+    sweep.signalCount = fixed.parameters.signalCount;
+    sweep.signalStep = fixed.parameters.signalStep;
+    sweep.noiseCount = fixed.parameters.noiseCount;
+    sweep.histogramBins = fixed.parameters.histogramBins;
+    sweep.noiseSeed = fixed.parameters.noiseSeed;
+
+    return true;
+}
+
+// Rendering figures needs a QGuiApplication (for fonts), which loads a platform plugin.
+// The parser isn't set up yet when the application is created, so look at argv directly.
+bool figuresRequested(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        QByteArray argument(argv[i]);
+
+        if (argument == "--") {
+            break;
+        }
+        if (argument == "--figures" || argument.startsWith("--figures=")) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int main(int argc, char *argv[])
+{
+    QScopedPointer<QCoreApplication> app;
+
+    // runs without figures only need QtCore
+    if (figuresRequested(argc, argv)) {
+        // figures are rendered without a display
+        if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        }
+
+        app.reset(new QGuiApplication(argc, argv));
+    }
+    else {
+        app.reset(new QCoreApplication(argc, argv));
+    }
+
+    QCoreApplication::setApplicationName("dsp1-cli");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Runs the DSP1 signal pipeline without a GUI and writes "
+                                     "the entropies (and optionally the probability tables) to disk.");
+    parser.addHelpOption();
+
+    QCommandLineOption configOption(QStringList() << "c" << "config",
+                                    "JSON file with one configuration object or an array of them. "
+                                    "Keys are the camelCase option names, e.g. \"signalCount\"; "
+                                    "missing keys take the command-line values.", "file");
+    QCommandLineOption outputOption(QStringList() << "o" << "output",
+                                    "Output directory (default: current directory).", "directory", ".");
+    QCommandLineOption tablesOption("tables", "Also write the probability tables of every run.");
+    QCommandLineOption signalsOption("signals", "Also write the signal, noise and sum of every run "
+                                     "as binary signal files (.dsp1).");
+    QCommandLineOption figuresOption("figures", "Also plot the signal, noise and sum of every run and their "
+                                     "histograms, as png or pdf files. Needs no display.", "format");
+    QCommandLineOption sweepOption(QStringList() << "s" << "sweep",
+                                   "JSON file with parameter ranges, e.g. {\"signalA\": {\"from\": 100, \"to\": 1000, "
+                                   "\"steps\": 10}}. The grid is evaluated in parallel into sweep.txt.", "file");
+
+    QCommandLineOption analyzeOption(QStringList() << "a" << "analyze",
+                                     "Streams over a binary signal file of any size page by page and prints its "
+                                     "statistics and entropy (with --bins bins) instead of running the pipeline.", "file");
+
+    QCommandLineOption convolveOption("convolve",
+                                      "Streams a binary signal file of any size through an overlap-add convolution "
+                                      "with --kernel and writes the result to convolution.dsp1.", "file");
+    QCommandLineOption kernelOption("kernel", "Kernel of --convolve, a binary signal file that fits into memory.",
+                                    "file");
+
+    QCommandLineOption monteCarloOption(QStringList() << "m" << "monte-carlo",
+                                        "Repeats noise -> sum -> histogram -> entropy up to this many times with "
+                                        "independent seeds and writes the mean entropies and their confidence "
+                                        "intervals to montecarlo.txt.", "realizations");
+    QCommandLineOption toleranceOption("tolerance", "Monte Carlo only: stop once the confidence intervals are "
+                                       "at most this many bits wide on either side (default: run all).", "bits");
+    QCommandLineOption confidenceOption("confidence", "Monte Carlo only: confidence level (default: 0.95).", "level");
+
+    QCommandLineOption estimatorOption(QStringList() << "e" << "estimator",
+                                       "Entropy estimator of results.txt: plugin (default), miller-madow, jackknife, "
+                                       "knn (Kozachenko-Leonenko) or kde (kernel density).", "name", "plugin");
+
+    parser.addOption(configOption);
+    parser.addOption(analyzeOption);
+    parser.addOption(convolveOption);
+    parser.addOption(kernelOption);
+    parser.addOption(estimatorOption);
+    parser.addOption(monteCarloOption);
+    parser.addOption(toleranceOption);
+    parser.addOption(confidenceOption);
+    parser.addOption(sweepOption);
+    parser.addOption(outputOption);
+    parser.addOption(tablesOption);
+    parser.addOption(signalsOption);
+    parser.addOption(figuresOption);
+
+    for (const ParameterOption& option : parameterOptions()) {
+        parser.addOption(QCommandLineOption(option.option, option.description, "value"));
+    }
+
+    parser.process(*app);
+
+    QTextStream errors(stderr);
+    QString error;
+
+    RunConfiguration base;
+    base.name = "run0001";
+    base.parameters = defaultParameters();
+
+    for (const ParameterOption& option : parameterOptions()) {
+        if (parser.isSet(option.option) && !option.set(base.parameters, parser.value(option.option))) {
+            errors << "dsp1-cli: invalid value of --" << option.option << "\n";
+            return 1;
+        }
+    }
+
+    if (parser.isSet(analyzeOption)) {
+        QElapsedTimer timer;
+        timer.start();
+
+        ChunkedSignal recording;
+
+        if (!recording.open(parser.value(analyzeOption), &error)) {
+            errors << "dsp1-cli: " << error << "\n";
+            return 1;
+        }
+
+        if (!recording.setHistogram(base.parameters.histogramBins, &error)) {
+            errors << "dsp1-cli: " << error << "\n";
+            return 1;
+        }
+
+        const SignalStatistics& statistics = recording.getStatistics();
+
+        QTextStream output(stdout);
+        output << "Samples " << statistics.count << "\n"
+               << "Min " << statistics.min << "\n"
+               << "Max " << statistics.max << "\n"
+               << "Mean " << statistics.mean << "\n"
+               << "Variance " << statistics.variance << "\n"
+               << "Skewness " << statistics.skewness << "\n"
+               << "Kurtosis " << statistics.kurtosis << "\n"
+               << "Entropy " << recording.getEntropy() << "\n";
+
+        errors << "dsp1-cli: " << recording.getPageCount() << " page(s) in " << timer.elapsed() << " ms\n";
+
+        return 0;
+    }
+
+    QDir outputDir(parser.value(outputOption));
+
+    if (!outputDir.mkpath(".")) {
+        errors << "dsp1-cli: cannot create " << outputDir.path() << "\n";
+        return 1;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    if (parser.isSet(convolveOption)) {
+        ChunkedSignal recording;
+        Signal kernel;
+
+        if (!parser.isSet(kernelOption)) {
+            errors << "dsp1-cli: --convolve needs a --kernel\n";
+            return 1;
+        }
+
+        if (!recording.open(parser.value(convolveOption), &error)
+            || !kernel.setByFile(parser.value(kernelOption), &error)) {
+            errors << "dsp1-cli: " << error << "\n";
+            return 1;
+        }
+
+        QString fileName = outputDir.filePath("convolution.dsp1");
+
+        if (!ChunkedSignal::writeConvolution(recording, kernel.getSignal(), fileName, Float64Format, &error)) {
+            errors << "dsp1-cli: " << error << "\n";
+            return 1;
+        }
+
+        errors << "dsp1-cli: " << recording.getPageCount() << " page(s) convolved in " << timer.elapsed() << " ms\n";
+
+        return 0;
+    }
+
+    if (parser.isSet(sweepOption)) {
+        SweepParameters sweep;
+
+        if (!loadSweep(parser.value(sweepOption), base, sweep, error)) {
+            errors << "dsp1-cli: " << error << "\n";
+            return 1;
+        }
+
+        QVector<SweepPoint> points;
+
+        if (!ParameterSweep::run(sweep, points, 0, &error)) {
+            errors << "dsp1-cli: " << error << "\n";
+            return 1;
+        }
+
+        QString fileName = outputDir.filePath("sweep.txt");
+
+        if (!ParameterSweep::writeResults(points, fileName)) {
+            errors << "dsp1-cli: cannot write " << fileName << "\n";
+            return 1;
+        }
+
+        errors << "dsp1-cli: " << points.size() << " sweep point(s) in " << timer.elapsed() << " ms\n";
+
+        return 0;
+    }
+
+    if (parser.isSet(monteCarloOption)) {
+        MonteCarloSettings settings = MonteCarloEntropy::defaultSettings();
+        bool ok = true;
+
+        settings.maxRealizations = parser.value(monteCarloOption).toInt(&ok);
+
+        if (ok && parser.isSet(toleranceOption)) {
+            settings.tolerance = parser.value(toleranceOption).toDouble(&ok);
+        }
+        if (ok && parser.isSet(confidenceOption)) {
+            settings.confidence = parser.value(confidenceOption).toDouble(&ok);
+            ok = ok && settings.confidence > 0 && settings.confidence < 1;
+        }
+
+        if (!ok) {
+            errors << "dsp1-cli: invalid Monte Carlo settings\n";
+            return 1;
+        }
+
+        MonteCarloResult result;
+
+        if (!MonteCarloEntropy::run(base.parameters, settings, result, 0, &error)) {
+            errors << "dsp1-cli: " << error << "\n";
+            return 1;
+        }
+
+        QString fileName = outputDir.filePath("montecarlo.txt");
+
+        if (!MonteCarloEntropy::writeResults(result, fileName)) {
+            errors << "dsp1-cli: cannot write " << fileName << "\n";
+            return 1;
+        }
+
+        errors << "dsp1-cli: " << result.realizations << " realization(s)"
+               << (result.converged ? " (converged)" : "") << " in " << timer.elapsed() << " ms\n";
+
+        return 0;
+    }
+
+    const QMap<QString, EntropyEstimator> estimators {
+        {"plugin", PlugInEstimator},
+        {"miller-madow", MillerMadowEstimator},
+        {"jackknife", JackknifeEstimator},
+        {"knn", KozachenkoLeonenkoEstimator},
+        {"kde", KernelDensityEstimator}
+    };
+
+    if (!estimators.contains(parser.value(estimatorOption))) {
+        errors << "dsp1-cli: unknown estimator " << parser.value(estimatorOption) << "\n";
+        return 1;
+    }
+
+    EntropyEstimator estimator = estimators.value(parser.value(estimatorOption));
+    QString figureFormat = parser.value(figuresOption).toLower();
+
+    if (parser.isSet(figuresOption) && figureFormat != "png" && figureFormat != "pdf") {
+        errors << "dsp1-cli: unknown figure format " << parser.value(figuresOption) << "\n";
+        return 1;
+    }
+
+    QVector<RunConfiguration> configurations;
+
+    if (parser.isSet(configOption)) {
+        if (!loadConfigurations(parser.value(configOption), base, configurations, error)) {
+            errors << "dsp1-cli: " << error << "\n";
+            return 1;
+        }
+    }
+    else {
+        configurations.push_back(base);
+    }
+
+    QFile resultsFile(outputDir.filePath("results.txt"));
+
+    if (!resultsFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        errors << "dsp1-cli: cannot write " << resultsFile.fileName() << "\n";
+        return 1;
+    }
+
+    QTextStream results(&resultsFile);
+    results << "Name " << signalLabel << " " << noiseLabel << " " << sumLabel << " " << convolutionLabel << "\n";
+
+    // consecutive runs that share stages (e.g. only the bins differ) reuse them
+    PipelineCache cache(pipelineCacheSamples);
+    QAtomicInt canceled(0);
+
+    for (const RunConfiguration& configuration : configurations) {
+        SignalMap data = SignalPipeline::compute(configuration.parameters, canceled,
+                                                 SignalPipeline::ProgressCallback(), &cache);
+
+        results << configuration.name << " "
+                << data[signalLabel].getEntropy(estimator) << " "
+                << data[noiseLabel].getEntropy(estimator) << " "
+                << data[sumLabel].getEntropy(estimator) << " "
+                << data[histogramConvolutionLabel].getEntropy(estimator) << "\n";
+
+        if (parser.isSet(tablesOption)) {
+            for (const QString& label : {signalLabel, noiseLabel, sumLabel}) {
+                QString fileName = outputDir.filePath(configuration.name + "_" + label.toLower() + ".txt");
+
+                if (!writeProbabilityTable(data[label], fileName)) {
+                    errors << "dsp1-cli: cannot write " << fileName << "\n";
+                    return 1;
+                }
+            }
+        }
+
+        if (parser.isSet(signalsOption)) {
+            for (const QString& label : {signalLabel, noiseLabel, sumLabel}) {
+                QString fileName = outputDir.filePath(configuration.name + "_" + label.toLower() + ".dsp1");
+
+                if (!writeSignalFile(data[label].getView(), fileName)) {
+                    errors << "dsp1-cli: cannot write " << fileName << "\n";
+                    return 1;
+                }
+            }
+        }
+
+        if (parser.isSet(figuresOption)) {
+            QVector<PlotFigure> figures;
+            QStringList fileNames;
+
+            for (const QString& label : {signalLabel, noiseLabel, sumLabel}) {
+                QString fileName = outputDir.filePath(configuration.name + "_" + label.toLower());
+
+                figures << PlotFigure::graph(data[label]) << PlotFigure::histogram(data[label]);
+                fileNames << fileName + "." + figureFormat << fileName + "_histogram." + figureFormat;
+            }
+
+            // the figures of a run are rendered in parallel
+            if (!PlotRenderer().save(figures, fileNames, &error)) {
+                errors << "dsp1-cli: " << error << "\n";
+                return 1;
+            }
+        }
+    }
+
+    results.flush();
+
+    errors << "dsp1-cli: " << configurations.size() << " run(s) in " << timer.elapsed() << " ms\n";
+
+    return resultsFile.error() == QFile::NoError ? 0 : 1;
+}
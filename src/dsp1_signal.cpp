@@ -1,77 +1,260 @@
 #include "dsp1_signal.h"
+#include "constants.h"
+#include "signalfile.h"
+#include "fft.h"
+#include "signalgenerators.h"
+#include "histogram.h"
+#include "parallel.h"
 
 #define _USE_MATH_DEFINES
 #include <math.h>
-#include <QMap>
-#include <random>
 #include <algorithm>
+#include <numeric>
+#include <limits>
 
-Signal::Signal() : min(0), max(0), histogramBins(0) {
+Signal::Signal() : format(Float64Format), histogramBinWidth(0), min(0), max(0), histogramBins(0),
+    seed(noiseDefaultSeed), statisticsValid(false) {
 }
 
-void Signal::setMinMax() {
-    auto minmax = std::minmax_element(signal.begin(), signal.end());
-    min = *(minmax.first);
-    max = *(minmax.second);
+// samples summed per block, small enough for the block to stay in L1 cache
+const int sumBlockSize = 2048;
+// a thread is only worth starting for this many samples
+const long long sumMinChunk = 1 << 16;
+
+namespace {
+
+// Sums inputs[k][first, first + size) into block, in the same order for every format
+void sumBlock(const QVector<SampleView>& inputs, long long first, int size, double* block) {
+    visitSamples(inputs[0], [&](auto a) {
+        std::copy(a + first, a + first + size, block);
+    });
+
+    for (int k = 1; k < inputs.size(); ++k) {
+        visitSamples(inputs[k], [&](auto c) {
+            c += first;
+
+            for (int i = 0; i < size; ++i) {
+                block[i] += c[i];
+            }
+        });
+    }
 }
 
-void Signal::setBySum(const std::initializer_list<Signal> signalsToAdd) {
-    size_t minSize = 0;
+// Stores the sum of inputs in output[0, size) and returns its range
+template<typename T>
+void sumSamples(const QVector<SampleView>& inputs, int size, T* output, double& min, double& max) {
+    int chunks = parallelChunkCount(size, sumMinChunk);
+    QVector<double> chunkMin(chunks);
+    QVector<double> chunkMax(chunks);
+
+    // one pass over the inputs: every block is summed and scanned for min/max while in cache
+    parallelChunks(size, chunks, [&](int chunk, long long begin, long long end) {
+        double blockMin = std::numeric_limits<double>::infinity();
+        double blockMax = -blockMin;
+        double scratch[std::is_same<T, double>::value ? 1 : sumBlockSize];
+
+        for (long long first = begin; first < end; first += sumBlockSize) {
+            int blockSize = static_cast<int>(std::min<long long>(sumBlockSize, end - first));
+            T* out = output + first;
+
+            if constexpr (std::is_same<T, double>::value) {
+                sumBlock(inputs, first, blockSize, out);
+            }
+            else {
+                sumBlock(inputs, first, blockSize, scratch);
 
-    for (auto s : signalsToAdd) {
-        if (s.getSize() < minSize || minSize == 0) {
-            minSize = s.getSize();
+                for (int i = 0; i < blockSize; ++i) {
+                    out[i] = sampleCast<T>(scratch[i]);
+                }
+            }
+
+            for (int i = 0; i < blockSize; ++i) {
+                blockMin = std::min(blockMin, static_cast<double>(out[i]));
+                blockMax = std::max(blockMax, static_cast<double>(out[i]));
+            }
         }
-    }
 
-    signal.clear();
-    signal.reserve(minSize);
+        chunkMin[chunk] = blockMin;
+        chunkMax[chunk] = blockMax;
+    });
+
+    min = *std::min_element(chunkMin.begin(), chunkMin.end());
+    max = *std::max_element(chunkMax.begin(), chunkMax.end());
+}
 
-    QVector<double> tempSignal;
+template<typename A, typename B>
+QVector<double> directConvolve(const A* dataA, const B* dataB, int size) {
+    int convSize = 2*size - 1;
+    QVector<double> convolution(convSize);
 
-    for (size_t i = 0; i < minSize; ++i) {
+    for (int i = 0; i < convSize; ++i) {
+        int jFirst = std::max(0, i - size + 1);
+        int jLast = std::min(i, size - 1);
         double sum = 0;
 
-        for (auto s : signalsToAdd) {
-            tempSignal = s.getSignal();
-            sum += tempSignal[i];
+        for (int j = jFirst; j <= jLast; ++j) {
+            sum += static_cast<double>(dataA[i-j]) * dataB[j];
         }
 
-        signal.push_back(sum);
+        convolution[i] = sum;
     }
 
-    setMinMax();
+    return convolution;
 }
 
-void Signal::setByConvolution(const Signal& signalA, const Signal& signalB) {
-    int minSize = std::min(signalA.getSize(), signalB.getSize());
+SampleView viewOf(const QVector<double>& data) {
+    return {data.constData(), data.size(), Float64Format};
+}
+
+} // namespace
+
+template<>
+QVector<double>& Signal::storage<double>() {
+    return signal;
+}
+
+template<>
+QVector<float>& Signal::storage<float>() {
+    return signalFloat32;
+}
+
+template<>
+QVector<qint16>& Signal::storage<qint16>() {
+    return signalInt16;
+}
+
+// Drops every stored sample, the caller refills the vector of format
+void Signal::releaseSamples() {
+    file.reset();
+    widened.clear();
+    signal.clear();
+    signalFloat32.clear();
+    signalInt16.clear();
+}
+
+// Moves samples computed into signal to the storage of a narrower format
+void Signal::narrowSamples() {
+    if (format == Float64Format) {
+        return;
+    }
+
+    visitSamples({0, 0, format}, [&](auto typed) {
+        typedef SampleType<decltype(typed)> T;
+        QVector<T>& output = storage<T>();
+
+        output.resize(signal.size());
+
+        for (int i = 0; i < signal.size(); ++i) {
+            output[i] = sampleCast<T>(signal[i]);
+        }
+    });
 
     signal.clear();
-    signal.reserve(minSize);
+    signal.squeeze();
+}
+
+void Signal::setMinMax() {
+    statisticsValid = false;
+
+    SampleView samples = getView();
+
+    if (samples.size == 0) {
+        min = max = 0;
+        return;
+    }
+
+    visitSamples(samples, [&](auto data) {
+        auto minmax = std::minmax_element(data, data + samples.size);
+        min = *(minmax.first);
+        max = *(minmax.second);
+    });
+}
+
+void Signal::setBySum(const std::initializer_list<Signal> signalsToAdd) {
+    QVector<SampleView> views;
+    views.reserve(signalsToAdd.size());
+
+    for (const Signal& s : signalsToAdd) {
+        views.push_back(s.getView());
+    }
+
+    setBySum(views);
+}
+
+void Signal::setBySum(const QVector<SampleSpan>& signalsToAdd) {
+    QVector<SampleView> views;
+    views.reserve(signalsToAdd.size());
+
+    for (const SampleSpan& span : signalsToAdd) {
+        views.push_back({span.data, span.size, Float64Format});
+    }
+
+    setBySum(views);
+}
+
+void Signal::setBySum(const QVector<SampleView>& signalsToAdd) {
+    int minSize = 0;
+
+    for (int k = 0; k < signalsToAdd.size(); ++k) {
+        if (k == 0 || signalsToAdd[k].size < minSize) {
+            minSize = signalsToAdd[k].size;
+        }
+    }
+
+    if (minSize == 0) {
+        releaseSamples();
+        setMinMax();
+        return;
+    }
+
+    // inputs may view the samples of this signal, so the sum goes to a new vector
+    visitSamples({0, 0, format}, [&](auto typed) {
+        typedef SampleType<decltype(typed)> T;
+        QVector<T> output(minSize);
+
+        sumSamples(signalsToAdd, minSize, output.data(), min, max);
+
+        releaseSamples();
+        storage<T>() = output;
+    });
 
-    QVector<double> signalAData = signalA.getSignal();
-    QVector<double> signalBData = signalB.getSignal();
+    statisticsValid = false;
+}
+
+void Signal::setByConvolution(const Signal& signalA, const Signal& signalB) {
+    QVector<double> convolution = convolve(signalA.getView(), signalB.getView());
 
-    signal = convolve(signalAData, signalBData);
+    releaseSamples();
+    signal = convolution;
+    narrowSamples();
 
     setMinMax();
 }
 
-QVector<double> Signal::convolve(const QVector<double>& dataA, const QVector<double>& dataB) {
-    int minSize = std::min(dataA.size(), dataB.size());
-    int convSize = 2*minSize - 1;
+QVector<double> Signal::convolve(const SampleView& dataA, const SampleView& dataB) {
+    int minSize = std::min(dataA.size, dataB.size);
+
+    if (minSize == 0) {
+        return QVector<double>();
+    }
 
     QVector<double> convolution;
-    convolution.resize(convSize);
 
-    for (int i = 0; i < convSize; ++i) {
-        for (int j = 0; j <= i; ++j) {
-            if ((i-j) < minSize && j < minSize) {
-                convolution[convSize - 1 - i] += dataA[i-j] * dataB[j];
-            }
-        }
+    // the direct sum is cheaper than the transforms for short inputs
+    if (minSize < convolutionFftThreshold) {
+        convolution = visitSamples(dataA, [&](auto a) {
+            return visitSamples(dataB, [&](auto b) {
+                return directConvolve(a, b, minSize);
+            });
+        });
+    }
+    else {
+        convolution = fftConvolve({dataA.data, minSize, dataA.format}, {dataB.data, minSize, dataB.format});
     }
 
+    // convolution is stored in reverse order
+    std::reverse(convolution.begin(), convolution.end());
+
     return convolution;
 }
 
@@ -80,10 +263,13 @@ void Signal::convolveHistograms(Signal& anotherSignal, int bins) {
     setHistogram(bins);
     anotherSignal.setHistogram(bins);
 
-    QVector<double> convolution = convolve(histogramYAxis, anotherSignal.getHistogramYAxis());
+    const QVector<double>& anotherHistogram = anotherSignal.getHistogramYAxis();
+    QVector<double> convolution = convolve(viewOf(histogramYAxis), viewOf(anotherHistogram));
 
     histogramYAxis.clear();
     histogramYAxis = convolution;
+    histogramCountsPerBin.clear();
+    histogramBinWidth = 0;
 
     histogramXAxis.clear();
     histogramXAxis.resize(convolution.size());
@@ -92,25 +278,11 @@ void Signal::convolveHistograms(Signal& anotherSignal, int bins) {
 }
 
 void Signal::setByFormula(int count, double step, double a, double sigma, double mu) {
-    signal.clear();
-    signal.reserve(count);
-
-    auto formula = [&, count, step, a, sigma, mu](int k) -> double {
-        double result = 0;
-        double a_k = 0;
-        double cos_f = 0;
-        double x_k = k * step;
-
-        a_k = ( a * exp( -(x_k-mu)*(x_k-mu)/(2*sigma*sigma) ) ) / ( sigma*sqrt(2*M_PI) );
-        cos_f = cos( pow((x_k-count*step/2), 2) / 20 );
+    releaseSamples();
+    signal.resize(std::max(count, 0));
 
-        result = a_k * cos_f;
-        return result;
-    };
-
-    for(int k = 0; k < count; ++k) {
-        signal.push_back(formula(k));
-    }
+    generateFormula(signal.data(), signal.size(), step, a, sigma, mu);
+    narrowSamples();
 
     setMinMax();
 }
@@ -137,59 +309,142 @@ void Signal::setByTriangle(int count, double height) {
 }
 */
 
-void Signal::setByNoise(int count, double mean, double sd, double lowBoundary, double highBoundary) {
-    std::default_random_engine generator;
-    std::normal_distribution<double> distribution(mean, sd);
+void Signal::setByNoise(int count, double mean, double sd, double lowBoundary, double highBoundary,
+                        NoiseSampling sampling) {
+    releaseSamples();
+    signal.resize(std::max(count, 0));
 
-    signal.clear();
+    generateNoise(signal.data(), signal.size(), mean, sd, lowBoundary, highBoundary, seed, sampling);
+    narrowSamples();
 
-    for (int i = 0; i < count; ++i) {
-        double number = distribution(generator);
+    setMinMax();
+}
 
-        if (number >= lowBoundary && number <= highBoundary) {
-            signal.push_back(number);
-        }
-        else {
-            --i;
-        }
+bool Signal::setByFile(const QString& fileName, QString* error) {
+    std::shared_ptr<const MappedSignalFile> opened = MappedSignalFile::open(fileName, error);
+
+    if (!opened) {
+        return false;
+    }
+
+    releaseSamples();
+    signal.squeeze();
+    signalFloat32.squeeze();
+    signalInt16.squeeze();
+    file = opened;
+    format = file->getView().format;
+
+    // a single parallel pass over the mapping yields min/max and fills the statistics cache
+    SampleView samples = getView();
+    statistics = visitSamples(samples, [&](auto data) {
+        return computeStatistics(data, samples.size);
+    });
+    statisticsValid = true;
+    min = statistics.min;
+    max = statistics.max;
+
+    return true;
+}
+
+void Signal::setFormat(SampleFormat format) {
+    if (format == this->format) {
+        return;
     }
 
+    QVector<double> values = getSignal();
+
+    releaseSamples();
+    this->format = format;
+    signal = values;
+    narrowSamples();
 
     setMinMax();
 }
 
-double Signal::hround(double value, double bin) {
-   return ( floor(value/bin)  );
+SampleFormat Signal::getFormat() const {
+    return format;
+}
+
+void Signal::setSeed(quint64 seed) {
+    this->seed = seed;
+}
+
+quint64 Signal::getSeed() const {
+    return seed;
 }
 
 void Signal::setHistogram(double bins) {
-    QMap<double, double> histogram;
     histogramBins = bins;
-    histogramXAxis.clear();
-    histogramYAxis.clear();
 
-    double histogramBin = fabs( getMax()-getMin() ) / histogramBins;
+    SampleView samples = getView();
+    HistogramLayout layout = histogramLayout(getMin(), getMax(), histogramBins, samples.size);
+    QVector<qint64> counts;
 
-    for (auto i = 0; i < signal.size(); ++i) {
-        ++histogram[hround(signal[i], histogramBin)];
+    // the counting pass reads every sample anyway, so the moments come along for free
+    visitSamples(samples, [&](auto data) {
+        if (statisticsValid) {
+            counts = histogramCounts(data, samples.size, layout);
+        }
+        else {
+            statistics = computeStatistics(data, samples.size, layout, counts);
+            statisticsValid = true;
+        }
+    });
+
+    histogramXAxis.resize(layout.size);
+    histogramYAxis.resize(layout.size);
+
+    for (int i = 0; i < layout.size; ++i) {
+        histogramXAxis[i] = (layout.firstKey + i) * layout.binWidth;
+        histogramYAxis[i] = static_cast<double>(counts[i]) / samples.size;
     }
 
-    // fill unused keys values with zeros
-    for (double i = hround(getMin(), histogramBin); i <= hround(getMax(), histogramBin); ++i) {
-        histogram[i];
+    histogramCountsPerBin = counts;
+    histogramBinWidth = layout.binWidth;
+}
+
+const QVector<double> &Signal::getSignal() const {
+    if (format == Float64Format && !file) {
+        return signal;
     }
 
-    histogramXAxis.reserve(histogramBins);
-    histogramYAxis.reserve(histogramBins);
+    SampleView samples = getView();
+
+    if (widened.size() != samples.size) {
+        widened.resize(samples.size);
 
-    for (auto const& point : histogram.toStdMap()) {
-        histogramXAxis.push_back(point.first * histogramBin);
-        histogramYAxis.push_back(point.second / signal.size());
+        visitSamples(samples, [&](auto data) {
+            std::copy(data, data + samples.size, widened.begin());
+        });
     }
+
+    return widened;
 }
 
-const QVector<double> &Signal::getSignal() const {
-    return signal;
+SampleSpan Signal::getSamples() const {
+    SampleView samples = getView();
+
+    if (format != Float64Format) {
+        const QVector<double>& values = getSignal();
+        return {values.constData(), values.size()};
+    }
+
+    return {static_cast<const double*>(samples.data), samples.size};
+}
+
+SampleView Signal::getView() const {
+    if (file) {
+        return file->getView();
+    }
+
+    switch (format) {
+        case Float32Format:
+            return {signalFloat32.constData(), signalFloat32.size(), format};
+        case Int16Format:
+            return {signalInt16.constData(), signalInt16.size(), format};
+        default:
+            return {signal.constData(), signal.size(), format};
+    }
 }
 
 double Signal::getMax() const {
@@ -200,6 +455,18 @@ double Signal::getMin() const {
     return min;
 }
 
+const SignalStatistics& Signal::getStatistics() const {
+    if (!statisticsValid) {
+        SampleView samples = getView();
+        statistics = visitSamples(samples, [&](auto data) {
+            return computeStatistics(data, samples.size);
+        });
+        statisticsValid = true;
+    }
+
+    return statistics;
+}
+
 const QVector<double>& Signal::getHistogramXAxis() const {
     return histogramXAxis;
 }
@@ -212,18 +479,26 @@ const QVector<double>& Signal::getProbability() const {
     return histogramYAxis;
 }
 
-double Signal::getEntropy() const {
-    double entropy = 0;
-
-    for (int i = 0; i < histogramYAxis.size(); ++i) {
-        if (histogramYAxis[i]) {
-            entropy += histogramYAxis[i] * log2(histogramYAxis[i]);
-        }
+double Signal::getEntropy(EntropyEstimator estimator) const {
+    // a single bin (e.g. a constant signal) has no spread to estimate
+    if (histogramCountsPerBin.size() < 2) {
+        return histogramEntropy(histogramYAxis);
     }
 
-    return ( -entropy );
+    switch (estimator) {
+        case MillerMadowEstimator:
+            return millerMadowEntropy(histogramCountsPerBin);
+        case JackknifeEstimator:
+            return jackknifeEntropy(histogramCountsPerBin);
+        case KozachenkoLeonenkoEstimator:
+            return kozachenkoLeonenkoEntropy(getView()) - log2(histogramBinWidth);
+        case KernelDensityEstimator:
+            return kernelDensityEntropy(getView()) - log2(histogramBinWidth);
+        default:
+            return histogramEntropy(histogramYAxis);
+    }
 }
 
 size_t Signal::getSize() const {
-    return signal.size();
+    return getView().size;
 }
@@ -0,0 +1,233 @@
+#include "entropy.h"
+#include "fft.h"
+#include "statistics.h"
+#include "parallel.h"
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+// grid points of the binned kernel density estimate
+const int kdeGridSize = 1024;
+// the Gaussian kernel is cut off this many bandwidths from its center
+const double kdeKernelRadius = 4;
+// a thread is only worth starting for this many distances
+const long long neighbourMinChunk = 1 << 15;
+
+// n*log2(n), 0 for n = 0
+double entropyTerm(double n) {
+    return n > 0 ? n * log2(n) : 0;
+}
+
+// psi(x) for x > 0: shifted until the asymptotic series is accurate
+double digamma(double x) {
+    double result = 0;
+
+    while (x < 6) {
+        result -= 1 / x;
+        x += 1;
+    }
+
+    double inverse = 1 / x;
+    double inverse2 = inverse * inverse;
+
+    result += log(x) - 0.5 * inverse
+            - inverse2 * (1.0/12 - inverse2 * (1.0/120 - inverse2 * (1.0/252 - inverse2 * (1.0/240 - inverse2 / 132))));
+
+    return result;
+}
+
+QVector<double> sortedSamples(const SampleView& samples) {
+    QVector<double> sorted(samples.size);
+
+    visitSamples(samples, [&](auto data) {
+        std::copy(data, data + samples.size, sorted.begin());
+    });
+
+    std::sort(sorted.begin(), sorted.end());
+
+    return sorted;
+}
+
+} // namespace
+
+double plugInEntropy(const QVector<qint64>& counts) {
+    qint64 total = 0;
+    double sum = 0;
+
+    for (qint64 count : counts) {
+        total += count;
+        sum += entropyTerm(count);
+    }
+
+    // H = log2(N) - sum(n*log2(n))/N
+    return total > 0 ? log2(static_cast<double>(total)) - sum / total : 0;
+}
+
+double millerMadowEntropy(const QVector<qint64>& counts) {
+    qint64 total = 0;
+    int occupied = 0;
+
+    for (qint64 count : counts) {
+        total += count;
+        occupied += count > 0;
+    }
+
+    if (total == 0) {
+        return 0;
+    }
+
+    return plugInEntropy(counts) + (occupied - 1) / (2.0 * total * M_LN2);
+}
+
+double jackknifeEntropy(const QVector<qint64>& counts) {
+    qint64 total = 0;
+    double sum = 0;
+
+    for (qint64 count : counts) {
+        total += count;
+        sum += entropyTerm(count);
+    }
+
+    if (total < 2) {
+        return plugInEntropy(counts);
+    }
+
+    double n = static_cast<double>(total);
+    double plugIn = log2(n) - sum / n;
+
+    // leaving out any one sample of a bin with c samples gives the same entropy,
+    // so the N leave-one-out estimates collapse to one term per bin
+    double leaveOneOut = 0;
+
+    for (qint64 count : counts) {
+        if (count > 0) {
+            double reduced = sum - entropyTerm(count) + entropyTerm(count - 1);
+            leaveOneOut += count * (log2(n - 1) - reduced / (n - 1));
+        }
+    }
+
+    return n * plugIn - (n - 1) / n * leaveOneOut;
+}
+
+double kozachenkoLeonenkoEntropy(const SampleView& samples, int k) {
+    int n = samples.size;
+    k = std::max(1, k);
+
+    if (n <= k) {
+        return 0;
+    }
+
+    QVector<double> sorted = sortedSamples(samples);
+    const double* x = sorted.constData();
+
+    // repeated values (e.g. int16 samples) have no distance, they are
+    // treated as half the smallest spacing between distinct values apart
+    double minSpacing = std::numeric_limits<double>::infinity();
+
+    for (int i = 1; i < n; ++i) {
+        if (x[i] > x[i - 1]) {
+            minSpacing = std::min(minSpacing, x[i] - x[i - 1]);
+        }
+    }
+
+    if (!std::isfinite(minSpacing)) {
+        return 0;
+    }
+
+    int chunks = parallelChunkCount(n, neighbourMinChunk);
+    QVector<double> chunkSums(chunks, 0);
+
+    // the k nearest neighbours of x[i] in sorted data are a window [low, low + k] around i,
+    // and the best window start never moves left as i grows
+    parallelChunks(n, chunks, [&](int chunk, long long begin, long long end) {
+        int low = static_cast<int>(std::max(0LL, begin - k));
+        double sum = 0;
+
+        for (int i = static_cast<int>(begin); i < end; ++i) {
+            low = std::max(low, i - k);
+
+            while (low + k + 1 < n && x[low + k + 1] - x[i] < x[i] - x[low]) {
+                ++low;
+            }
+
+            double distance = std::max(x[i] - x[low], x[low + k] - x[i]);
+            sum += log(2 * std::max(distance, minSpacing / 2));
+        }
+
+        chunkSums[chunk] = sum;
+    });
+
+    double sum = 0;
+
+    for (double chunkSum : chunkSums) {
+        sum += chunkSum;
+    }
+
+    // h = psi(N) - psi(k) + log(c_1) + mean(log(distance)), c_1 = 2 in one dimension
+    return (digamma(n) - digamma(k) + sum / n) / M_LN2;
+}
+
+double kernelDensityEntropy(const SampleView& samples, double bandwidth) {
+    int n = samples.size;
+
+    if (n < 2) {
+        return 0;
+    }
+
+    SignalStatistics statistics = visitSamples(samples, [&](auto data) {
+        return computeStatistics(data, n);
+    });
+
+    double sd = sqrt(statistics.variance);
+
+    if (!(bandwidth > 0)) {
+        bandwidth = 1.06 * sd * pow(static_cast<double>(n), -0.2);
+    }
+    if (!(bandwidth > 0)) {
+        return 0;
+    }
+
+    // linear binning onto a grid that also covers the kernel tails
+    double first = statistics.min - kdeKernelRadius * bandwidth;
+    double last = statistics.max + kdeKernelRadius * bandwidth;
+    double delta = (last - first) / (kdeGridSize - 1);
+    QVector<double> grid(kdeGridSize, 0);
+
+    visitSamples(samples, [&](auto data) {
+        for (int i = 0; i < n; ++i) {
+            double position = (data[i] - first) / delta;
+            int left = std::min(static_cast<int>(position), kdeGridSize - 2);
+            double weight = position - left;
+
+            grid[left] += 1 - weight;
+            grid[left + 1] += weight;
+        }
+    });
+
+    int radius = std::min(static_cast<int>(ceil(kdeKernelRadius * bandwidth / delta)), kdeGridSize - 1);
+    QVector<double> kernel(2 * radius + 1);
+
+    for (int i = -radius; i <= radius; ++i) {
+        double u = i * delta / bandwidth;
+        kernel[i + radius] = exp(-u * u / 2) / (sqrt(2 * M_PI) * bandwidth * n);
+    }
+
+    QVector<double> density = fftConvolve(grid.constData(), grid.size(), kernel.constData(), kernel.size());
+
+    // h = -integral f*log(f), the grid keeps the samples away from its ends
+    double entropy = 0;
+
+    for (int i = 0; i < kdeGridSize; ++i) {
+        double f = density[i + radius];
+
+        if (f > 0) {
+            entropy -= f * log2(f) * delta;
+        }
+    }
+
+    return entropy;
+}
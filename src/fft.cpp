@@ -0,0 +1,127 @@
+#include "fft.h"
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <algorithm>
+
+int fftLength(int minLength) {
+    int length = 1;
+
+    while (length < minLength) {
+        length <<= 1;
+    }
+
+    return length;
+}
+
+void fft(QVector<Complex>& data, bool inverse) {
+    int n = data.size();
+
+    if (n < 2) {
+        return;
+    }
+
+    Complex* x = data.data();
+
+    // bit-reversal permutation
+    for (int i = 1, j = 0; i < n; ++i) {
+        int bit = n >> 1;
+
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+
+        if (i < j) {
+            std::swap(x[i], x[j]);
+        }
+    }
+
+    // twiddles are evaluated once per transform instead of being accumulated
+    // by repeated multiplication, which keeps the error at O(log n)
+    QVector<Complex> twiddles(n / 2);
+    double sign = inverse ? 1 : -1;
+
+    for (int k = 0; k < n / 2; ++k) {
+        double angle = sign * 2 * M_PI * k / n;
+        twiddles[k] = Complex(cos(angle), sin(angle));
+    }
+
+    for (int length = 2; length <= n; length <<= 1) {
+        int half = length / 2;
+        int stride = n / length;
+
+        for (int i = 0; i < n; i += length) {
+            for (int k = 0; k < half; ++k) {
+                Complex t = twiddles[k * stride] * x[i + k + half];
+
+                x[i + k + half] = x[i + k] - t;
+                x[i + k] += t;
+            }
+        }
+    }
+
+    if (inverse) {
+        for (int i = 0; i < n; ++i) {
+            x[i] /= n;
+        }
+    }
+}
+
+namespace {
+
+template<typename A, typename B>
+QVector<double> convolveTransformed(const A* dataA, int sizeA, const B* dataB, int sizeB) {
+    if (sizeA <= 0 || sizeB <= 0) {
+        return QVector<double>();
+    }
+
+    int convSize = sizeA + sizeB - 1;
+    int n = fftLength(convSize);
+
+    // both real inputs are packed into a single complex transform: z = a + ib
+    QVector<Complex> z(n);
+
+    for (int i = 0; i < sizeA; ++i) {
+        z[i].real(static_cast<double>(dataA[i]));
+    }
+    for (int i = 0; i < sizeB; ++i) {
+        z[i].imag(static_cast<double>(dataB[i]));
+    }
+
+    fft(z);
+
+    // A[k]*B[k] = (Z[k]^2 - conj(Z[n-k])^2) / 4i
+    QVector<Complex> product(n);
+
+    for (int k = 0; k < n; ++k) {
+        Complex zk = z[k];
+        Complex zn = std::conj(z[(n - k) & (n - 1)]);
+
+        product[k] = (zk*zk - zn*zn) * Complex(0, -0.25);
+    }
+
+    fft(product, true);
+
+    QVector<double> convolution(convSize);
+
+    for (int i = 0; i < convSize; ++i) {
+        convolution[i] = product[i].real();
+    }
+
+    return convolution;
+}
+
+} // namespace
+
+QVector<double> fftConvolve(const double* dataA, int sizeA, const double* dataB, int sizeB) {
+    return convolveTransformed(dataA, sizeA, dataB, sizeB);
+}
+
+QVector<double> fftConvolve(const SampleView& dataA, const SampleView& dataB) {
+    return visitSamples(dataA, [&](auto a) {
+        return visitSamples(dataB, [&](auto b) {
+            return convolveTransformed(a, dataA.size, b, dataB.size);
+        });
+    });
+}
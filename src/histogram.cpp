@@ -0,0 +1,126 @@
+#include "histogram.h"
+#include "parallel.h"
+
+#include <cmath>
+
+// below this every thread would spend more time starting than counting
+const long long histogramMinChunk = 1 << 16;
+// int16 inputs of at least this many samples are first counted per distinct value
+const long long histogramValueTableMinSize = 1 << 17;
+
+HistogramLayout histogramLayout(double min, double max, double bins, long long samples) {
+    HistogramLayout layout;
+    layout.binWidth = fabs(max - min) / bins;
+    layout.firstKey = 0;
+    layout.size = 0;
+
+    if (samples <= 0) {
+        return layout;
+    }
+
+    // a constant signal (or a degenerate bins value) falls into a single bin
+    if (!(layout.binWidth > 0) || !std::isfinite(layout.binWidth)) {
+        layout.binWidth = 1;
+        layout.firstKey = floor(min);
+        layout.size = 1;
+        return layout;
+    }
+
+    layout.firstKey = floor(min / layout.binWidth);
+    layout.size = static_cast<int>(floor(max / layout.binWidth) - layout.firstKey) + 1;
+
+    return layout;
+}
+
+double histogramEntropy(const QVector<double>& probability) {
+    return histogramEntropy(probability.constData(), probability.size());
+}
+
+double histogramEntropy(const double* probability, int size) {
+    double entropy = 0;
+
+    for (int i = 0; i < size; ++i) {
+        if (probability[i]) {
+            entropy += probability[i] * log2(probability[i]);
+        }
+    }
+
+    return ( -entropy );
+}
+
+template<typename T>
+void histogramAccumulate(const T* data, long long size, const HistogramLayout& layout, qint64* counts) {
+    for (long long i = 0; i < size; ++i) {
+        ++counts[histogramIndex(data[i], layout)];
+    }
+}
+
+// int16 samples take only 65536 distinct values: counting those is a plain increment
+// per sample, and the floor/divide of histogramIndex runs once per value instead
+template<>
+void histogramAccumulate(const qint16* data, long long size, const HistogramLayout& layout, qint64* counts) {
+    if (size < histogramValueTableMinSize) {
+        for (long long i = 0; i < size; ++i) {
+            ++counts[histogramIndex(data[i], layout)];
+        }
+        return;
+    }
+
+    std::vector<qint64> values(1 << 16, 0);
+
+    for (long long i = 0; i < size; ++i) {
+        ++values[data[i] + 32768];
+    }
+
+    for (int value = 0; value < (1 << 16); ++value) {
+        if (values[value]) {
+            counts[histogramIndex(value - 32768, layout)] += values[value];
+        }
+    }
+}
+
+template<typename T>
+QVector<qint64> histogramCounts(const T* data, long long size, const HistogramLayout& layout) {
+    QVector<qint64> counts(layout.size, 0);
+
+    if (layout.size == 0) {
+        return counts;
+    }
+
+    int chunks = parallelChunkCount(size, histogramMinChunk);
+
+    if (chunks == 1) {
+        histogramAccumulate(data, size, layout, counts.data());
+        return counts;
+    }
+
+    // every thread counts into a private histogram ...
+    std::vector<QVector<qint64>> partial(chunks);
+
+    parallelChunks(size, chunks, [&](int chunk, long long begin, long long end) {
+        partial[chunk].fill(0, layout.size);
+        histogramAccumulate(data + begin, end - begin, layout, partial[chunk].data());
+    });
+
+    // ... which are then merged bin range by bin range
+    int mergeChunks = parallelChunkCount(layout.size, histogramMinChunk);
+    qint64* total = counts.data();
+
+    parallelChunks(layout.size, mergeChunks, [&](int, long long begin, long long end) {
+        for (const auto& part : partial) {
+            const qint64* partCounts = part.constData();
+
+            for (long long i = begin; i < end; ++i) {
+                total[i] += partCounts[i];
+            }
+        }
+    });
+
+    return counts;
+}
+
+template void histogramAccumulate(const double*, long long, const HistogramLayout&, qint64*);
+template void histogramAccumulate(const float*, long long, const HistogramLayout&, qint64*);
+template QVector<qint64> histogramCounts(const double*, long long, const HistogramLayout&);
+template QVector<qint64> histogramCounts(const float*, long long, const HistogramLayout&);
+template QVector<qint64> histogramCounts(const qint16*, long long, const HistogramLayout&);
@@ -1,14 +1,38 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include "constants.h"
+#include "signalio.h"
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::MainWindow),
     bars(NULL),
+    progressBar(new QProgressBar(this)),
+    pipeline(new SignalPipeline(this)),
+    signalProbabilityModel(new ProbabilityTableModel(this)),
+    noiseProbabilityModel(new ProbabilityTableModel(this)),
+    sumProbabilityModel(new ProbabilityTableModel(this)),
+    computing(false),
     firstStart(true)
 {
     ui->setupUi(this);
+
+    // draw the graphs in their own buffer, concurrently with the grid and the axes
+    ui->plot->layer("main")->setMode(QCPLayer::lmBuffered);
+    ui->plot->setThreadedReplot(true);
+
+    progressBar->setRange(0, 100);
+    progressBar->hide();
+    ui->statusBar->addPermanentWidget(progressBar);
+
+    setupTable(ui->tableSignProb, signalProbabilityModel);
+    setupTable(ui->tableNoiseProb, noiseProbabilityModel);
+    setupTable(ui->tableSumProb, sumProbabilityModel);
+
+    connect(pipeline, &SignalPipeline::progressChanged, this, &MainWindow::onPipelineProgress, Qt::QueuedConnection);
+    connect(pipeline, &SignalPipeline::finished, this, &MainWindow::onPipelineFinished, Qt::QueuedConnection);
+    connect(pipeline, &SignalPipeline::canceled, this, &MainWindow::onPipelineCanceled, Qt::QueuedConnection);
+
     on_buttonSetDefault_clicked();
     on_buttonRun_clicked();
     ui->tabWidget->setCurrentIndex(0);
@@ -17,87 +41,36 @@ MainWindow::MainWindow(QWidget *parent) :
 
 MainWindow::~MainWindow()
 {
+    pipeline->cancel();
+    pipeline->wait();
+
     ui->plot->clearPlottables();
     delete ui;
 }
 
-void MainWindow::createTable(QTableWidget* table, int numOfRows, int numOfCols, const QVector<QString>& horizHeaders) {
-    table->setRowCount(numOfRows);
-    table->setColumnCount(numOfCols);
+void MainWindow::setupTable(QTableView* table, QAbstractItemModel* model) {
+    table->setModel(model);
 
-    for (int i = 0; i < numOfCols; ++i) {
-        table->horizontalHeader()->setSectionResizeMode(i, QHeaderView::Stretch);
-
-        if (!horizHeaders.empty() && i < horizHeaders.size()) {
-            table->setHorizontalHeaderItem(i, new QTableWidgetItem(horizHeaders[i]));
-        }
-    }
+    table->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
 
+    // uniform rows keep scrolling independent of the number of bins
+    table->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
     table->verticalHeader()->hide();
 
     table->setEditTriggers(QAbstractItemView::NoEditTriggers);
 }
 
-
-// Only works for numeric types
-// Table can only be filled with data of __the same__ type
-
-template<typename T, typename>
-void MainWindow::fillTable(QTableWidget* table, const std::initializer_list<QVector<T>> colsData) {
-    int colIndex = 0;
-
-    for (auto col : colsData) {
-        for (int i = 0; i < col.size() && i < table->rowCount(); ++i) {
-            table->setItem(i, colIndex, new QTableWidgetItem(QString::number(col[i])));
-        }
-
-        ++colIndex;
+void MainWindow::saveProbabilityToFile(QString fileName, const Signal& signal) {
+    if (fileName.isEmpty()) {
+        return;
     }
-}
-
-QStringList MainWindow::tableToQStringList(QTableWidget* table) {
-    int rows = table->rowCount();
-    int columns = table->columnCount();
 
-    QStringList result;
-    QString headers;
-
-    for (int i = 0; i < columns; ++i) {
-        headers += table->horizontalHeaderItem(i)->data(Qt::DisplayRole).toString() + " ";
-    }
-
-    result  << headers << "\n";
-
-    for (int i = 0; i < rows; ++i) {
-        QString tempStr = "";
-
-        for (int j = 0; j < columns; ++j) {
-            if (table->item(i, j)) {
-                tempStr += table->item(i, j)->text() + " ";
-            }
-        }
-
-        result << tempStr << "\n";
-        tempStr.clear();
-    }
-
-    return result;
-}
-
-void MainWindow::saveTableToFile(QString fileName, QTableWidget* table) {
     if (!fileName.contains(".txt", Qt::CaseInsensitive)) {
         fileName += ".txt";
     }
 
-    QFile file(fileName);
-
-    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-        QTextStream output(&file);
-        QStringList tableData = tableToQStringList(table);
-
-        for (auto row : tableData) {
-            output << row;
-        }
+    if (!writeProbabilityTable(signal, fileName)) {
+        ui->statusBar->showMessage(tr("Could not write %1").arg(fileName));
     }
 }
 
@@ -136,7 +109,9 @@ void MainWindow::plotGraph(const QVector<double>& xAxis, const QVector<double>&
     ui->plot->clearPlottables();
 
     ui->plot->addGraph();
-    ui->plot->graph(0)->setData(xAxis, yAxis);
+    // signals have millions of samples, sample the pixel columns from a min/max index
+    ui->plot->graph(0)->setAdaptiveSamplingIndex(true);
+    ui->plot->graph(0)->setData(xAxis, yAxis, true);
 
     ui->plot->yAxis->rescale();
     ui->plot->xAxis->rescale();
@@ -164,61 +139,93 @@ void MainWindow::plotBars(const QVector<double>& xAxis, const QVector<double>& y
 
 void MainWindow::on_buttonRun_clicked()
 {
-    int currentTabIndex = ui->tabWidget->currentIndex();
-    QString currentTabTitle = ui->tabWidget->tabText(currentTabIndex);
+    if (computing) {
+        pipeline->cancel();
+        return;
+    }
 
     // signal variables
-    int signalCount = ui->varSignalCount->text().toInt();
-    double signalStep = ui->varSignalStep->text().toDouble();
-    double signalA = ui->varSignalA->text().toDouble();
-    double signalSigma = ui->varSignalSigma->text().toDouble();
-    double signalMu = ui->varSignalMu->text().toDouble();
+    parameters.signalCount = ui->varSignalCount->text().toInt();
+    parameters.signalStep = ui->varSignalStep->text().toDouble();
+    parameters.signalA = ui->varSignalA->text().toDouble();
+    parameters.signalSigma = ui->varSignalSigma->text().toDouble();
+    parameters.signalMu = ui->varSignalMu->text().toDouble();
 
     // noise variables
-    double noiseMean = ui->varNoiseMean->text().toDouble();
-    double noiseSD = ui->varNoiseSD->text().toDouble();
-    int noiseCount = ui->varNoiseCount->text().toDouble();
+    parameters.noiseMean = ui->varNoiseMean->text().toDouble();
+    parameters.noiseSD = ui->varNoiseSD->text().toDouble();
+    parameters.noiseCount = ui->varNoiseCount->text().toDouble();
 
     // histogram variables
-    double histogramBins = ui->varHistogramBins->text().toDouble();
+    parameters.histogramBins = ui->varHistogramBins->text().toDouble();
+
+    parameters.noiseSeed = noiseDefaultSeed;
+
+    // the previous run may still be returning from its worker
+    pipeline->wait();
+
+    if (pipeline->start(parameters)) {
+        setRunning(true);
+    }
+}
+
+void MainWindow::setRunning(bool running) {
+    computing = running;
 
-    Signal tempSignal;
+    ui->buttonRun->setText(running ? tr("Cancel [Enter]") : tr("Run [Enter]"));
+    ui->buttonSetDefault->setDisabled(running);
+    ui->buttonSave->setDisabled(running);
 
-    tempSignal.setByFormula(signalCount, signalStep, signalA, signalSigma, signalMu);
-    data[signalLabel] = tempSignal;
+    progressBar->setValue(0);
+    progressBar->setVisible(running);
 
-    tempSignal.setByNoise(noiseCount, noiseMean, noiseSD, data[signalLabel].getMin(), data[signalLabel].getMax());
-    data[noiseLabel] = tempSignal;
+    if (!running) {
+        ui->statusBar->clearMessage();
+    }
+}
+
+void MainWindow::onPipelineProgress(int percent, const QString& stage)
+{
+    progressBar->setValue(percent);
+    ui->statusBar->showMessage(stage);
+}
 
-    tempSignal.setBySum({data[signalLabel], data[noiseLabel]});
-    data[sumLabel] = tempSignal;
+void MainWindow::onPipelineFinished(const SignalMap& results)
+{
+    setRunning(false);
 
-    tempSignal.setByConvolution(data[signalLabel], data[noiseLabel]);
-    data[convolutionLabel] = tempSignal;
+    data = results;
+    showResults();
+}
+
+void MainWindow::onPipelineCanceled()
+{
+    setRunning(false);
+}
+
+void MainWindow::showResults() {
+    int currentTabIndex = ui->tabWidget->currentIndex();
+    QString currentTabTitle = ui->tabWidget->tabText(currentTabIndex);
 
     if (currentTabTitle == tabHistogramTitle) {
-        QString radio;
+        // the pipeline has binned every choice already, nothing is recomputed on the UI thread
+        QString radio = signalLabel;
 
-        if (ui->radioSignal->isChecked()) {
-            radio = signalLabel;
-        }
-        else if (ui->radioNoise->isChecked()) {
+        if (ui->radioNoise->isChecked()) {
             radio = noiseLabel;
         }
         else if (ui->radioSum->isChecked()) {
             radio = sumLabel;
         }
-
-        data[radio].setHistogram(histogramBins);
-
-        if (ui->radioConvolution->isChecked()) {
-            radio = signalLabel;
-            data[radio].convolveHistograms(data[noiseLabel], histogramBins);
+        else if (ui->radioConvolution->isChecked()) {
+            radio = histogramConvolutionLabel;
         }
 
-        ui->fieldEntropy->setText(QString::number(data[radio].getEntropy()));
+        if (data.contains(radio)) {
+            ui->fieldEntropy->setText(QString::number(data[radio].getEntropy()));
 
-        plotHistogram(data[radio]);
+            plotHistogram(data[radio]);
+        }
     }
     else if (ui->checkBoxSumSignNoise->isChecked()) {
         plotGraph(data[sumLabel]);
@@ -233,28 +240,37 @@ void MainWindow::on_buttonRun_clicked()
         plotGraph(data[noiseLabel]);
     }
 
-    // calculate & display probability
-
-    createTable(ui->tableSignProb, data[signalLabel].getSize(), tableProbabilityColumnsCount, tableProbabilityHeaders);
-    createTable(ui->tableNoiseProb, data[noiseLabel].getSize(), tableProbabilityColumnsCount, tableProbabilityHeaders);
-    createTable(ui->tableSumProb, data[sumLabel].getSize(), tableProbabilityColumnsCount, tableProbabilityHeaders);
+    // display probability
 
-    fillTable(ui->tableSignProb, {data[signalLabel].getHistogramXAxis(), data[signalLabel].getProbability()});
-    fillTable(ui->tableNoiseProb, {data[noiseLabel].getHistogramXAxis(), data[noiseLabel].getProbability()});
-    fillTable(ui->tableSumProb, {data[sumLabel].getHistogramXAxis(), data[sumLabel].getProbability()});
+    signalProbabilityModel->setSignal(data[signalLabel]);
+    noiseProbabilityModel->setSignal(data[noiseLabel]);
+    sumProbabilityModel->setSignal(data[sumLabel]);
 }
 
 
 void MainWindow::on_buttonSave_clicked()
 {
+    QString pdfFilter = tr("PDF (*.pdf)");
+    QString selectedFilter;
     QString fileName = QFileDialog::getSaveFileName(this, tr("Save File"), QDir::homePath(),
-                                                        tr("Images (*.png)"));
+                                                        tr("Images (*.png)") + ";;" + pdfFilter, &selectedFilter);
 
-    if (!fileName.contains(".png", Qt::CaseInsensitive)) {
-        fileName += ".png";
+    if (fileName.isEmpty()) {
+        return;
     }
 
-    ui->plot->savePng(fileName);
+    QString suffix = selectedFilter == pdfFilter ? ".pdf" : ".png";
+
+    if (!fileName.endsWith(suffix, Qt::CaseInsensitive)) {
+        fileName += suffix;
+    }
+
+    // exports the plot as shown, including zoom and pan
+    bool saved = suffix == ".pdf" ? ui->plot->savePdf(fileName) : ui->plot->savePng(fileName);
+
+    if (!saved) {
+        ui->statusBar->showMessage(tr("Could not write %1").arg(fileName));
+    }
 }
 
 void MainWindow::on_tabWidget_currentChanged(int index)
@@ -303,7 +319,7 @@ void MainWindow::on_buttonSaveSignProb_clicked()
     QString fileName = QFileDialog::getSaveFileName(this, tr("Save File"), QDir::homePath(),
                                                         tr("Text files (*.txt)"));
 
-    saveTableToFile(fileName, ui->tableSignProb);
+    saveProbabilityToFile(fileName, data[signalLabel]);
 }
 
 void MainWindow::on_buttonSaveNoiseProb_clicked()
@@ -311,7 +327,7 @@ void MainWindow::on_buttonSaveNoiseProb_clicked()
     QString fileName = QFileDialog::getSaveFileName(this, tr("Save File"), QDir::homePath(),
                                                         tr("Text files (*.txt)"));
 
-    saveTableToFile(fileName, ui->tableNoiseProb);
+    saveProbabilityToFile(fileName, data[noiseLabel]);
 }
 
 void MainWindow::on_buttonSaveSumProb_clicked()
@@ -319,5 +335,5 @@ void MainWindow::on_buttonSaveSumProb_clicked()
     QString fileName = QFileDialog::getSaveFileName(this, tr("Save File"), QDir::homePath(),
                                                         tr("Text files (*.txt)"));
 
-    saveTableToFile(fileName, ui->tableSumProb);
+    saveProbabilityToFile(fileName, data[sumLabel]);
 }
@@ -0,0 +1,157 @@
+#include "montecarlo.h"
+#include "batchhistogram.h"
+#include "randomstream.h"
+#include "statistics.h"
+#include "parallel.h"
+
+#include <QFile>
+#include <QTextStream>
+#include <cmath>
+
+namespace {
+
+// x with P(Z <= x) = p for a standard normal Z, by bisection on erfc
+double normalQuantile(double p) {
+    double low = -40;
+    double high = 40;
+
+    for (int i = 0; i < 100; ++i) {
+        double middle = (low + high) / 2;
+
+        if (0.5 * std::erfc(-middle / std::sqrt(2.0)) < p) {
+            low = middle;
+        }
+        else {
+            high = middle;
+        }
+    }
+
+    return (low + high) / 2;
+}
+
+} // namespace
+
+MonteCarloSettings MonteCarloEntropy::defaultSettings() {
+    MonteCarloSettings settings;
+
+    settings.maxRealizations = 1000;
+    settings.minRealizations = 30;
+    settings.roundSize = 32;
+    settings.confidence = 0.95;
+    settings.tolerance = 0;
+
+    return settings;
+}
+
+EntropyEstimate MonteCarloEntropy::estimate(const QVector<double>& entropies, double confidence) {
+    SignalStatistics statistics = computeStatistics(entropies.constData(), entropies.size());
+    double halfWidth = 0;
+
+    if (statistics.count > 1) {
+        halfWidth = normalQuantile((1 + confidence) / 2) * std::sqrt(statistics.variance / statistics.count);
+    }
+
+    EntropyEstimate estimate;
+    estimate.mean = statistics.mean;
+    estimate.variance = statistics.variance;
+    estimate.low = statistics.mean - halfWidth;
+    estimate.high = statistics.mean + halfWidth;
+
+    return estimate;
+}
+
+bool MonteCarloEntropy::run(const PipelineParameters& parameters, const MonteCarloSettings& settings,
+                            MonteCarloResult& result, const QAtomicInt* canceled, QString* error) {
+    result = MonteCarloResult();
+    result.realizations = 0;
+    result.converged = false;
+    result.noise = result.sum = estimate(QVector<double>(), settings.confidence);
+
+    // the signal does not depend on the seed
+    Signal signal;
+    signal.setByFormula(parameters.signalCount, parameters.signalStep, parameters.signalA,
+                        parameters.signalSigma, parameters.signalMu);
+
+    int roundSize = std::max(settings.roundSize, 1);
+    int workers = parallelWorkerCount();
+
+    while (result.realizations < settings.maxRealizations && !result.converged) {
+        if (canceled && canceled->loadAcquire()) {
+            break;
+        }
+
+        int first = result.realizations;
+        int count = std::min(roundSize, settings.maxRealizations - first);
+
+        std::vector<Signal> noises(count);
+        std::vector<Signal> sums(count);
+
+        // one realization per task, the noise and sum kernels stay on the task's worker
+        parallelForStealing(count, workers, [&](int, long long i) {
+            // every realization draws its seed from its own stream of the base seed
+            RandomStream seeds(parameters.noiseSeed, first + i);
+
+            noises[i].setSeed(seeds.nextBits());
+            noises[i].setByNoise(parameters.noiseCount, parameters.noiseMean, parameters.noiseSD,
+                                 signal.getMin(), signal.getMax());
+            sums[i].setBySum({signal.getView(), noises[i].getView()});
+        });
+
+        // the histograms of a whole round are binned together
+        QVector<SampleView> views;
+        views.reserve(2 * count);
+
+        for (int i = 0; i < count; ++i) {
+            views.push_back(noises[i].getView());
+        }
+        for (int i = 0; i < count; ++i) {
+            views.push_back(sums[i].getView());
+        }
+
+        HistogramBatch histograms = batchHistograms(views, parameters.histogramBins, error);
+
+        if (histograms.signalCount != views.size()) {
+            return false;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            result.noiseEntropies.push_back(histograms.entropy[i]);
+            result.sumEntropies.push_back(histograms.entropy[count + i]);
+        }
+
+        result.realizations += count;
+        result.noise = estimate(result.noiseEntropies, settings.confidence);
+        result.sum = estimate(result.sumEntropies, settings.confidence);
+
+        double halfWidth = std::max(result.noise.high - result.noise.mean, result.sum.high - result.sum.mean);
+
+        result.converged = settings.tolerance > 0 && result.realizations >= settings.minRealizations
+                        && halfWidth <= settings.tolerance;
+    }
+
+    return true;
+}
+
+bool MonteCarloEntropy::writeResults(const MonteCarloResult& result, const QString& fileName) {
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    QTextStream output(&file);
+
+    output << "Name Realizations Converged Mean Variance Low High \n";
+
+    auto row = [&](const QString& name, const EntropyEstimate& estimate) {
+        output << name << " " << result.realizations << " " << (result.converged ? 1 : 0) << " "
+               << estimate.mean << " " << estimate.variance << " " << estimate.low << " " << estimate.high << " \n";
+    };
+
+    row("Noise", result.noise);
+    row("Sum", result.sum);
+
+    output.flush();
+
+    return file.error() == QFile::NoError;
+}
@@ -0,0 +1,152 @@
+#include "parametersweep.h"
+#include "dsp1_signal.h"
+#include "parallel.h"
+
+#include <QFile>
+#include <QTextStream>
+#include <limits>
+
+// QVector sizes are ints, and the allocation in bytes has to fit too
+const long long maxSweepPoints = std::numeric_limits<int>::max() / static_cast<int>(sizeof(SweepPoint));
+
+int SweepRange::count() const {
+    return std::max(1, steps);
+}
+
+double SweepRange::value(int index) const {
+    if (count() == 1) {
+        return from;
+    }
+
+    return from + (to - from) * index / (count() - 1);
+}
+
+const SweepRange& SweepParameters::range(SweepParameter parameter) const {
+    switch (parameter) {
+        case SweepSignalA: return signalA;
+        case SweepSignalSigma: return signalSigma;
+        case SweepSignalMu: return signalMu;
+        case SweepNoiseMean: return noiseMean;
+        case SweepNoiseSD: break;
+    }
+
+    return noiseSD;
+}
+
+long long ParameterSweep::pointCount(const SweepParameters& parameters) {
+    long long count = 1;
+
+    for (SweepParameter parameter : {SweepSignalA, SweepSignalSigma, SweepSignalMu, SweepNoiseMean, SweepNoiseSD}) {
+        int steps = parameters.range(parameter).count();
+
+        if (count > std::numeric_limits<long long>::max() / steps) {
+            return std::numeric_limits<long long>::max();
+        }
+
+        count *= steps;
+    }
+
+    return count;
+}
+
+bool ParameterSweep::run(const SweepParameters& parameters, QVector<SweepPoint>& points,
+                         const QAtomicInt* canceled, QString* error) {
+    long long count = pointCount(parameters);
+
+    if (count > maxSweepPoints) {
+        if (error) {
+            *error = QString("the sweep grid has too many points (at most %1)").arg(maxSweepPoints);
+        }
+        return false;
+    }
+
+    // count fits into an int, so its factors do too
+    int noisePoints = parameters.noiseMean.count() * parameters.noiseSD.count();
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+
+    points = QVector<SweepPoint>(static_cast<int>(count));
+
+    // the signal of the last point each worker handled
+    struct WorkerState {
+        long long signalIndex = -1;
+        Signal signal;
+    };
+
+    int workers = parallelWorkerCount();
+    std::vector<WorkerState> states(workers);
+    // workers write through the pointer, not the shared vector (detach checks)
+    SweepPoint* pointData = points.data();
+
+    // one point per task; the generators, sums and histograms it calls see that they run
+    // inside a parallel task and stay on its worker instead of starting threads of their own
+    parallelForStealing(count, workers, [&](int worker, long long index) {
+        SweepPoint& point = pointData[index];
+
+        long long signalIndex = index / noisePoints;
+        int noiseIndex = index % noisePoints;
+
+        int muIndex = signalIndex % parameters.signalMu.count();
+        int sigmaIndex = signalIndex / parameters.signalMu.count() % parameters.signalSigma.count();
+        int aIndex = signalIndex / parameters.signalMu.count() / parameters.signalSigma.count();
+
+        point.signalA = parameters.signalA.value(aIndex);
+        point.signalSigma = parameters.signalSigma.value(sigmaIndex);
+        point.signalMu = parameters.signalMu.value(muIndex);
+        point.noiseMean = parameters.noiseMean.value(noiseIndex / parameters.noiseSD.count());
+        point.noiseSD = parameters.noiseSD.value(noiseIndex % parameters.noiseSD.count());
+        point.signalEntropy = nan;
+        point.noiseEntropy = nan;
+        point.sumEntropy = nan;
+
+        if (canceled && canceled->loadAcquire()) {
+            return;
+        }
+
+        WorkerState& state = states[worker];
+
+        if (state.signalIndex != signalIndex) {
+            state.signal.setByFormula(parameters.signalCount, parameters.signalStep,
+                                      point.signalA, point.signalSigma, point.signalMu);
+            state.signal.setHistogram(parameters.histogramBins);
+            state.signalIndex = signalIndex;
+        }
+
+        Signal noise;
+        noise.setSeed(parameters.noiseSeed);
+        noise.setByNoise(parameters.noiseCount, point.noiseMean, point.noiseSD,
+                         state.signal.getMin(), state.signal.getMax());
+        noise.setHistogram(parameters.histogramBins);
+
+        Signal sum;
+        sum.setBySum({state.signal.getView(), noise.getView()});
+        sum.setHistogram(parameters.histogramBins);
+
+        point.signalEntropy = state.signal.getEntropy();
+        point.noiseEntropy = noise.getEntropy();
+        point.sumEntropy = sum.getEntropy();
+    });
+
+    return true;
+}
+
+bool ParameterSweep::writeResults(const QVector<SweepPoint>& points, const QString& fileName) {
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    QTextStream output(&file);
+
+    output << "a sigma mu mean sd Signal Noise Sum \n";
+
+    for (const SweepPoint& point : points) {
+        output << point.signalA << " " << point.signalSigma << " " << point.signalMu << " "
+               << point.noiseMean << " " << point.noiseSD << " "
+               << point.signalEntropy << " " << point.noiseEntropy << " " << point.sumEntropy << " \n";
+    }
+
+    output.flush();
+
+    return file.error() == QFile::NoError;
+}
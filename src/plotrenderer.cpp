@@ -0,0 +1,381 @@
+#include "plotrenderer.h"
+#include "parallel.h"
+
+#include <QPainter>
+#include <QPdfWriter>
+#include <QPageSize>
+#include <QFileInfo>
+#include <QFontMetricsF>
+#include <QPolygonF>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const double plotMargin = 10;
+const double tickLength = 5;
+// Pixels between ticks the tick step aims for
+const double tickSpacing = 80;
+const int maxTicks = 100;
+// Smallest axis range relative to the magnitude of its bounds and largest bound, as in QCPRange
+const double minRelativeRange = 1e-9;
+const double maxRange = 1e250;
+
+// Same look as the plot widget
+const QColor graphColor(Qt::blue);
+const QColor barPenColor(40, 50, 255);
+const QColor barBrushColor(40, 50, 255, 30);
+const QColor gridColor(200, 200, 200);
+
+struct AxisRange {
+    double lower;
+    double upper;
+
+    double size() const {
+        return upper - lower;
+    }
+};
+
+bool fail(QString* error, const QString& message) {
+    if (error) {
+        *error = message;
+    }
+    return false;
+}
+
+// Widens empty and nearly empty ranges, so every figure gets a scale with distinct ticks
+AxisRange paddedRange(double lower, double upper) {
+    if (!std::isfinite(lower) || !std::isfinite(upper)) {
+        lower = 0;
+        upper = 0;
+    }
+
+    lower = qBound(-maxRange, lower, maxRange);
+    upper = qBound(-maxRange, upper, maxRange);
+
+    double magnitude = std::max(std::abs(lower), std::abs(upper));
+
+    if (upper - lower <= magnitude * minRelativeRange) {
+        double center = lower / 2 + upper / 2;
+        double padding = magnitude == 0 ? 1 : magnitude / 2;
+        lower = center - padding;
+        upper = center + padding;
+    }
+
+    return {lower, upper};
+}
+
+// Multiples of 1, 2 or 5 times a power of ten, about tickSpacing pixels apart
+QVector<double> ticks(const AxisRange& range, double pixels) {
+    double roughStep = range.size() / std::max(2.0, std::floor(pixels / tickSpacing));
+    double magnitude = std::pow(10.0, std::floor(std::log10(roughStep)));
+    double step = magnitude;
+
+    for (double factor : {2.0, 5.0, 10.0}) {
+        if (step < roughStep) {
+            step = magnitude * factor;
+        }
+    }
+
+    QVector<double> result;
+    double first = std::ceil(range.lower / step) * step;
+
+    // an integer counter with a cap, so rounding can never keep the loop from ending
+    for (int i = 0; i <= maxTicks; ++i) {
+        double tick = first + i * step;
+
+        if (!(tick <= range.upper)) {
+            break;
+        }
+
+        result.push_back(tick);
+    }
+
+    return result;
+}
+
+QString tickLabel(double value) {
+    return QString::number(value, 'g', 6);
+}
+
+double textWidth(const QFontMetricsF& metrics, const QString& text) {
+    return metrics.boundingRect(text).width();
+}
+
+// Draws the samples as polylines broken at NaN. Pixel columns with several samples
+// keep their first, smallest, largest and last value, so peaks survive at any size.
+template<typename Position>
+void drawLine(QPainter& painter, int count, Position position) {
+    QPolygonF polyline;
+    int column = std::numeric_limits<int>::min();
+    QPointF first, low, high, last;
+
+    auto flushColumn = [&]() {
+        if (column == std::numeric_limits<int>::min()) {
+            return;
+        }
+
+        polyline << first;
+
+        if (low.y() != first.y() || high.y() != first.y()) {
+            // pixel y grows downwards, so the smallest value is the lowest point on screen
+            polyline << QPointF(first.x(), high.y()) << QPointF(first.x(), low.y());
+        }
+        if (last != first) {
+            polyline << last;
+        }
+
+        column = std::numeric_limits<int>::min();
+    };
+
+    auto flushLine = [&]() {
+        flushColumn();
+
+        if (polyline.size() > 1) {
+            painter.drawPolyline(polyline);
+        }
+
+        polyline.clear();
+    };
+
+    for (int i = 0; i < count; ++i) {
+        QPointF point = position(i);
+
+        if (!std::isfinite(point.x()) || !std::isfinite(point.y())) {
+            flushLine();
+            continue;
+        }
+
+        int pointColumn = static_cast<int>(std::floor(point.x()));
+
+        if (pointColumn != column) {
+            flushColumn();
+            column = pointColumn;
+            first = low = high = last = point;
+            continue;
+        }
+
+        if (point.y() > low.y()) {
+            low = point;
+        }
+        if (point.y() < high.y()) {
+            high = point;
+        }
+        last = point;
+    }
+
+    flushLine();
+}
+
+}
+
+PlotFigure PlotFigure::graph(const Signal& signal) {
+    PlotFigure figure;
+    figure.style = LinePlot;
+    figure.y = signal.getSignal();
+
+    return figure;
+}
+
+PlotFigure PlotFigure::histogram(const Signal& signal) {
+    PlotFigure figure;
+    figure.style = BarPlot;
+    figure.x = signal.getHistogramXAxis();
+    figure.y = signal.getHistogramYAxis();
+
+    return figure;
+}
+
+PlotRenderer::PlotRenderer(const QSize& size) : size(size) {
+}
+
+QSize PlotRenderer::getSize() const {
+    return size;
+}
+
+void PlotRenderer::render(QPainter& painter, const QRectF& rect, const PlotFigure& figure) const {
+    const int count = figure.y.size();
+    const bool indexed = figure.x.isEmpty();
+
+    auto keyAt = [&figure, indexed](int i) -> double {
+        return indexed ? i : figure.x[i];
+    };
+
+    // data ranges
+    double keyLower = std::numeric_limits<double>::infinity();
+    double keyUpper = -std::numeric_limits<double>::infinity();
+    double valueLower = std::numeric_limits<double>::infinity();
+    double valueUpper = -std::numeric_limits<double>::infinity();
+
+    for (int i = 0; i < count; ++i) {
+        double key = keyAt(i);
+        double value = figure.y[i];
+
+        if (std::isfinite(key) && std::isfinite(value)) {
+            keyLower = std::min(keyLower, key);
+            keyUpper = std::max(keyUpper, key);
+            valueLower = std::min(valueLower, value);
+            valueUpper = std::max(valueUpper, value);
+        }
+    }
+
+    double barWidth = 0;
+
+    if (figure.style == BarPlot && keyLower <= keyUpper) {
+        barWidth = count > 1 ? (keyUpper - keyLower) / (count - 1) : 1;
+        keyLower -= barWidth / 2;
+        keyUpper += barWidth / 2;
+        valueLower = std::min(valueLower, 0.0);
+        valueUpper = std::max(valueUpper, 0.0);
+    }
+
+    AxisRange keyRange = paddedRange(keyLower, keyUpper);
+    AxisRange valueRange = paddedRange(valueLower, valueUpper);
+
+    // layout: the value tick labels decide the left margin, one text line the bottom margin
+    painter.save();
+
+    QFontMetricsF metrics(painter.font(), painter.device());
+    QVector<double> valueTicks = ticks(valueRange, rect.height());
+    double labelWidth = 0;
+
+    for (double tick : valueTicks) {
+        labelWidth = std::max(labelWidth, textWidth(metrics, tickLabel(tick)));
+    }
+
+    QRectF area(QPointF(rect.left() + plotMargin + labelWidth + tickLength, rect.top() + plotMargin),
+                QPointF(rect.right() - plotMargin - textWidth(metrics, tickLabel(keyRange.upper)) / 2,
+                        rect.bottom() - plotMargin - metrics.height() - tickLength));
+    QVector<double> keyTicks = ticks(keyRange, area.width());
+
+    auto pixelX = [&](double key) -> double {
+        return area.left() + (key - keyRange.lower) / keyRange.size() * area.width();
+    };
+    auto pixelY = [&](double value) -> double {
+        return area.bottom() - (value - valueRange.lower) / valueRange.size() * area.height();
+    };
+
+    painter.fillRect(rect, Qt::white);
+
+    // grid
+    painter.setPen(QPen(gridColor, 0, Qt::DotLine));
+
+    for (double tick : keyTicks) {
+        painter.drawLine(QPointF(pixelX(tick), area.top()), QPointF(pixelX(tick), area.bottom()));
+    }
+    for (double tick : valueTicks) {
+        painter.drawLine(QPointF(area.left(), pixelY(tick)), QPointF(area.right(), pixelY(tick)));
+    }
+
+    // data
+    painter.save();
+    painter.setClipRect(area);
+
+    if (figure.style == BarPlot) {
+        painter.setPen(QPen(barPenColor, 0));
+        painter.setBrush(barBrushColor);
+
+        for (int i = 0; i < count; ++i) {
+            double key = keyAt(i);
+
+            if (std::isfinite(key) && std::isfinite(figure.y[i])) {
+                painter.drawRect(QRectF(QPointF(pixelX(key - barWidth / 2), pixelY(figure.y[i])),
+                                        QPointF(pixelX(key + barWidth / 2), pixelY(0))));
+            }
+        }
+    }
+    else {
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setPen(QPen(graphColor, 0));
+        drawLine(painter, count, [&](int i) {
+            return QPointF(pixelX(keyAt(i)), pixelY(figure.y[i]));
+        });
+    }
+
+    painter.restore();
+
+    // axes with inward ticks and their labels
+    painter.setPen(QPen(Qt::black, 0));
+    painter.drawLine(area.bottomLeft(), area.bottomRight());
+    painter.drawLine(area.bottomLeft(), area.topLeft());
+
+    for (double tick : keyTicks) {
+        double x = pixelX(tick);
+        QString label = tickLabel(tick);
+
+        painter.drawLine(QPointF(x, area.bottom()), QPointF(x, area.bottom() - tickLength));
+        painter.drawText(QPointF(x - textWidth(metrics, label) / 2, area.bottom() + tickLength + metrics.ascent()), label);
+    }
+    for (double tick : valueTicks) {
+        double y = pixelY(tick);
+        QString label = tickLabel(tick);
+
+        painter.drawLine(QPointF(area.left(), y), QPointF(area.left() + tickLength, y));
+        painter.drawText(QPointF(area.left() - tickLength - textWidth(metrics, label),
+                                 y + (metrics.ascent() - metrics.descent()) / 2), label);
+    }
+
+    painter.restore();
+}
+
+QImage PlotRenderer::toImage(const PlotFigure& figure) const {
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+
+    QPainter painter(&image);
+    render(painter, QRectF(QPointF(0, 0), QSizeF(size)), figure);
+
+    return image;
+}
+
+bool PlotRenderer::save(const PlotFigure& figure, const QString& fileName, QString* error) const {
+    if (QFileInfo(fileName).suffix().compare("pdf", Qt::CaseInsensitive) != 0) {
+        if (!toImage(figure).save(fileName)) {
+            return fail(error, QString("cannot write %1").arg(fileName));
+        }
+
+        return true;
+    }
+
+    // one pixel of the figure is one point of the page
+    QPdfWriter writer(fileName);
+    writer.setResolution(72);
+    writer.setPageSize(QPageSize(QSizeF(size), QPageSize::Point));
+    writer.setPageMargins(QMarginsF(0, 0, 0, 0));
+
+    QPainter painter;
+
+    if (!painter.begin(&writer)) {
+        return fail(error, QString("cannot write %1").arg(fileName));
+    }
+
+    render(painter, QRectF(QPointF(0, 0), QSizeF(size)), figure);
+
+    if (!painter.end()) {
+        return fail(error, QString("cannot write %1").arg(fileName));
+    }
+
+    return true;
+}
+
+bool PlotRenderer::save(const QVector<PlotFigure>& figures, const QStringList& fileNames, QString* error) const {
+    if (figures.size() != fileNames.size()) {
+        return fail(error, "every figure needs one file name");
+    }
+
+    QVector<QString> errors(figures.size());
+    QString* figureErrors = errors.data();
+
+    parallelForStealing(figures.size(), parallelWorkerCount(), [&](int, long long index) {
+        save(figures[index], fileNames[index], &figureErrors[index]);
+    });
+
+    for (const QString& figureError : errors) {
+        if (!figureError.isEmpty()) {
+            return fail(error, figureError);
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,54 @@
+#include "probabilitymodel.h"
+#include "constants.h"
+
+#include <algorithm>
+
+ProbabilityTableModel::ProbabilityTableModel(QObject *parent) :
+    QAbstractTableModel(parent)
+{
+}
+
+void ProbabilityTableModel::setSignal(const Signal& signal) {
+    beginResetModel();
+    bins = signal.getHistogramXAxis();
+    probability = signal.getProbability();
+    endResetModel();
+}
+
+int ProbabilityTableModel::rowCount(const QModelIndex &parent) const {
+    if (parent.isValid()) {
+        return 0;
+    }
+
+    return std::min(bins.size(), probability.size());
+}
+
+int ProbabilityTableModel::columnCount(const QModelIndex &parent) const {
+    if (parent.isValid()) {
+        return 0;
+    }
+
+    return tableProbabilityColumnsCount;
+}
+
+QVariant ProbabilityTableModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || role != Qt::DisplayRole || index.row() >= rowCount()) {
+        return QVariant();
+    }
+
+    const QVector<double>& column = (index.column() == 0) ? bins : probability;
+
+    return QString::number(column[index.row()]);
+}
+
+QVariant ProbabilityTableModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal) {
+        return QVariant();
+    }
+
+    if (section < 0 || section >= tableProbabilityHeaders.size()) {
+        return QVariant();
+    }
+
+    return tableProbabilityHeaders[section];
+}
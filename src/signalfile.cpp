@@ -0,0 +1,328 @@
+#include "signalfile.h"
+
+#include <QtEndian>
+#include <QSysInfo>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+// samples converted per block when the file cannot be used as is
+const int signalFileBlockSize = 8192;
+
+const bool hostIsLittleEndian = QSysInfo::ByteOrder == QSysInfo::LittleEndian;
+
+template<typename T>
+T readLittleEndian(const uchar* source) {
+    T value;
+    std::memcpy(&value, source, sizeof(T));
+    return qFromLittleEndian(value);
+}
+
+template<typename T>
+void writeLittleEndian(T value, uchar* destination) {
+    value = qToLittleEndian(value);
+    std::memcpy(destination, &value, sizeof(T));
+}
+
+// Raw bits of a sample, so byte order is handled by the integer overloads
+template<typename T> struct SampleBits;
+template<> struct SampleBits<double> { typedef quint64 Type; };
+template<> struct SampleBits<float> { typedef quint32 Type; };
+template<> struct SampleBits<qint16> { typedef quint16 Type; };
+
+template<typename T>
+T readSample(const uchar* source) {
+    typename SampleBits<T>::Type bits = readLittleEndian<typename SampleBits<T>::Type>(source);
+    T value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+template<typename T>
+void writeSample(T value, uchar* destination) {
+    typename SampleBits<T>::Type bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    writeLittleEndian(bits, destination);
+}
+
+bool fail(QString* error, const QString& message) {
+    if (error) {
+        *error = message;
+    }
+    return false;
+}
+
+bool parseHeader(const uchar* data, qint64 fileSize, SignalFileHeader& header, QString* error) {
+    if (std::memcmp(data, signalFileMagic, sizeof(signalFileMagic)) != 0) {
+        return fail(error, "not a signal file");
+    }
+
+    header.version = readLittleEndian<quint32>(data + 8);
+    quint32 type = readLittleEndian<quint32>(data + 12);
+    header.sampleCount = readLittleEndian<quint64>(data + 16);
+    header.dataOffset = readLittleEndian<quint64>(data + 24);
+    header.step = readSample<double>(data + 32);
+
+    if (header.version == 0 || header.version > signalFileVersion) {
+        return fail(error, QString("unsupported signal file version %1").arg(header.version));
+    }
+    if (type != Float64Format && type != Float32Format && type != Int16Format) {
+        return fail(error, QString("unsupported sample type %1").arg(type));
+    }
+
+    header.sampleType = static_cast<SampleFormat>(type);
+
+    if (header.dataOffset < static_cast<quint64>(signalFileHeaderSize) || header.dataOffset % 8 != 0) {
+        return fail(error, "invalid data offset");
+    }
+    quint64 dataSize = header.sampleCount * sampleFormatSize(header.sampleType);
+
+    if (static_cast<quint64>(fileSize) < header.dataOffset + dataSize) {
+        return fail(error, "signal file is truncated");
+    }
+
+    return true;
+}
+
+} // namespace
+
+bool readSignalFileHeader(QFile& file, SignalFileHeader& header, QString* error) {
+    QByteArray headerBytes;
+
+    if (file.seek(0)) {
+        headerBytes = file.read(signalFileHeaderSize);
+    }
+
+    if (headerBytes.size() != signalFileHeaderSize) {
+        return fail(error, QString("%1: not a signal file").arg(file.fileName()));
+    }
+
+    QString headerError;
+
+    if (!parseHeader(reinterpret_cast<const uchar*>(headerBytes.constData()), file.size(), header, &headerError)) {
+        return fail(error, QString("%1: %2").arg(file.fileName(), headerError));
+    }
+
+    return true;
+}
+
+void signalFileToHostOrder(void* samples, long long count, SampleFormat type) {
+    if (hostIsLittleEndian) {
+        return;
+    }
+
+    visitSamples({samples, 0, type}, [&](auto typed) {
+        typedef SampleType<decltype(typed)> T;
+        T* data = const_cast<T*>(typed);
+        const uchar* source = static_cast<const uchar*>(samples);
+
+        for (long long i = 0; i < count; ++i) {
+            data[i] = readSample<T>(source + i * sizeof(T));
+        }
+    });
+}
+
+MappedSignalFile::MappedSignalFile() : mapping(0) {
+    samples.data = 0;
+    samples.size = 0;
+    samples.format = Float64Format;
+}
+
+std::shared_ptr<const MappedSignalFile> MappedSignalFile::open(const QString& fileName, QString* error) {
+    std::shared_ptr<MappedSignalFile> result(new MappedSignalFile());
+    QFile& file = result->file;
+    SignalFileHeader& header = result->header;
+
+    file.setFileName(fileName);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        fail(error, QString("cannot open %1").arg(fileName));
+        return nullptr;
+    }
+
+    if (!readSignalFileHeader(file, header, error)) {
+        return nullptr;
+    }
+    if (header.sampleCount > static_cast<quint64>(std::numeric_limits<int>::max())) {
+        fail(error, QString("%1: too many samples for one signal, use ChunkedSignal").arg(fileName));
+        return nullptr;
+    }
+
+    int count = static_cast<int>(header.sampleCount);
+    int sampleSize = sampleFormatSize(header.sampleType);
+    qint64 dataSize = static_cast<qint64>(count) * sampleSize;
+
+    result->samples.format = header.sampleType;
+
+    if (count == 0) {
+        return result;
+    }
+
+    // the mapping stays valid as long as file is open, i.e. for the lifetime of result
+    if (hostIsLittleEndian) {
+        result->mapping = file.map(header.dataOffset, dataSize);
+    }
+
+    if (result->mapping) {
+        result->samples.data = result->mapping;
+        result->samples.size = count;
+        return result;
+    }
+
+    // big-endian host or no mmap support for this file, read it block by block instead
+    result->converted.resize(static_cast<int>((dataSize + 7) / 8));
+    uchar* output = reinterpret_cast<uchar*>(result->converted.data());
+
+    file.seek(header.dataOffset);
+
+    for (int first = 0; first < count; first += signalFileBlockSize) {
+        int size = std::min(signalFileBlockSize, count - first);
+        uchar* block = output + static_cast<qint64>(first) * sampleSize;
+
+        if (file.read(reinterpret_cast<char*>(block), static_cast<qint64>(size) * sampleSize)
+                != static_cast<qint64>(size) * sampleSize) {
+            fail(error, QString("%1: read error").arg(fileName));
+            return nullptr;
+        }
+
+        signalFileToHostOrder(block, size, header.sampleType);
+    }
+
+    result->samples.data = result->converted.constData();
+    result->samples.size = count;
+
+    return result;
+}
+
+const SignalFileHeader& MappedSignalFile::getHeader() const {
+    return header;
+}
+
+SampleView MappedSignalFile::getView() const {
+    return samples;
+}
+
+bool MappedSignalFile::isZeroCopy() const {
+    return mapping != 0;
+}
+
+namespace {
+
+bool writeHeader(QFile& file, SampleFormat type, qint64 count, double step) {
+    uchar header[signalFileHeaderSize] = {};
+
+    std::memcpy(header, signalFileMagic, sizeof(signalFileMagic));
+    writeLittleEndian<quint32>(signalFileVersion, header + 8);
+    writeLittleEndian<quint32>(type, header + 12);
+    writeLittleEndian<quint64>(std::max<qint64>(count, 0), header + 16);
+    writeLittleEndian<quint64>(signalFileHeaderSize, header + 24);
+    writeSample<double>(step, header + 32);
+
+    return file.seek(0)
+        && file.write(reinterpret_cast<const char*>(header), signalFileHeaderSize) == signalFileHeaderSize;
+}
+
+// Writes data[0, count) as little-endian samples of type T through a fixed-size buffer
+template<typename T, typename Source>
+bool writeSamples(QFile& file, const Source* data, int count) {
+    // the in-memory layout already is the file layout
+    if (std::is_same<T, Source>::value && hostIsLittleEndian) {
+        qint64 size = static_cast<qint64>(std::max(count, 0)) * sizeof(T);
+        return file.write(reinterpret_cast<const char*>(data), size) == size;
+    }
+
+    std::unique_ptr<uchar[]> block(new uchar[signalFileBlockSize * sizeof(T)]);
+
+    for (int first = 0; first < count; first += signalFileBlockSize) {
+        int size = std::min(signalFileBlockSize, count - first);
+
+        for (int i = 0; i < size; ++i) {
+            writeSample<T>(sampleCast<T>(data[first + i]), block.get() + i * sizeof(T));
+        }
+
+        qint64 bytes = static_cast<qint64>(size) * sizeof(T);
+
+        if (file.write(reinterpret_cast<const char*>(block.get()), bytes) != bytes) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // namespace
+
+SignalFileWriter::SignalFileWriter() : format(Float64Format), step(0), count(0), failed(false) {
+}
+
+SignalFileWriter::~SignalFileWriter() {
+    close();
+}
+
+bool SignalFileWriter::open(const QString& fileName, SampleFormat format, double step) {
+    close();
+
+    this->format = format;
+    this->step = step;
+    count = 0;
+    file.setFileName(fileName);
+
+    // the sample count is filled in by close()
+    failed = !file.open(QIODevice::WriteOnly | QIODevice::Truncate) || !writeHeader(file, format, 0, step);
+
+    return !failed;
+}
+
+bool SignalFileWriter::write(const SampleView& samples) {
+    if (failed || !file.isOpen()) {
+        return false;
+    }
+
+    failed = !visitSamples(samples, [&](auto data) {
+        switch (format) {
+            case Float32Format:
+                return writeSamples<float>(file, data, samples.size);
+            case Int16Format:
+                return writeSamples<qint16>(file, data, samples.size);
+            default:
+                return writeSamples<double>(file, data, samples.size);
+        }
+    });
+
+    count += samples.size;
+
+    return !failed;
+}
+
+bool SignalFileWriter::close() {
+    if (!file.isOpen()) {
+        return !failed;
+    }
+
+    failed = failed || !writeHeader(file, format, count, step);
+    file.close();
+
+    return !failed;
+}
+
+qint64 SignalFileWriter::getCount() const {
+    return count;
+}
+
+bool writeSignalFile(const SampleSpan& samples, const QString& fileName, SampleFormat type, double step) {
+    SignalFileWriter writer;
+
+    return writer.open(fileName, type, step)
+        && writer.write({samples.data, samples.size, Float64Format})
+        && writer.close();
+}
+
+bool writeSignalFile(const SampleView& samples, const QString& fileName, double step) {
+    SignalFileWriter writer;
+
+    return writer.open(fileName, samples.format, step)
+        && writer.write(samples)
+        && writer.close();
+}
@@ -0,0 +1,400 @@
+#include "signalgenerators.h"
+#include "randomstream.h"
+#include "parallel.h"
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+#define DSP1_X86_SIMD
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define DSP1_TARGET_AVX2
+#else
+#define DSP1_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+
+struct FormulaConstants {
+    double step;
+    double mu;
+    double a;
+    double norm;        // sigma*sqrt(2*pi)
+    double twoSigmaSq;  // 2*sigma^2
+    double center;      // count*step/2
+};
+
+inline double formulaSample(int k, const FormulaConstants& c) {
+    double x_k = k * c.step;
+    double a_k = ( c.a * exp( -(x_k-c.mu)*(x_k-c.mu)/c.twoSigmaSq ) ) / c.norm;
+    double cos_f = cos( (x_k-c.center)*(x_k-c.center) / 20 );
+
+    return a_k * cos_f;
+}
+
+void formulaScalar(double* output, int begin, int end, const FormulaConstants& c) {
+    for (int k = begin; k < end; ++k) {
+        output[k] = formulaSample(k, c);
+    }
+}
+
+#ifdef DSP1_X86_SIMD
+
+// Coefficients of the Cephes exp() and cos() approximations (double precision)
+const double expC1 = 6.93145751953125E-1;
+const double expC2 = 1.42860682030941723212E-6;
+const double expP[] = {1.26177193074810590878E-4, 3.02994407707441961300E-2, 9.99999999999999999910E-1};
+const double expQ[] = {3.00198505138664455042E-6, 2.52448340349684104192E-3, 2.27265548208155028766E-1,
+                       2.00000000000000000009E0};
+const double expMinArgument = -708.0;  // exp() of anything lower is treated as zero
+
+const double cosFourOverPi = 1.27323954473516268615;
+const double cosDP1 = 7.85398125648498535156E-1;
+const double cosDP2 = 3.77489470793079817668E-8;
+const double cosDP3 = 2.69515142907905952645E-15;
+const double sinCoef[] = {1.58962301576546568060E-10, -2.50507477628578072866E-8, 2.75573136213857245213E-6,
+                          -1.98412698295895385996E-4, 8.33333333332211858878E-3, -1.66666666666666307295E-1};
+const double cosCoef[] = {-1.13585365213876817300E-11, 2.08757008419747316778E-9, -2.75573141792967388112E-7,
+                          2.48015872888517045348E-5, -1.38888888888730564116E-3, 4.16666666666665929218E-2};
+// beyond this the three-part argument reduction loses precision, such lanes take the scalar path
+const double cosMaxArgument = 1.0e8;
+
+// 2 samples per step, SSE2 is part of every x86-64 CPU
+void formulaSse2(double* output, int count, const FormulaConstants& c) {
+    const __m128d step = _mm_set1_pd(c.step);
+    const __m128d mu = _mm_set1_pd(c.mu);
+    const __m128d a = _mm_set1_pd(c.a);
+    const __m128d norm = _mm_set1_pd(c.norm);
+    const __m128d twoSigmaSq = _mm_set1_pd(c.twoSigmaSq);
+    const __m128d center = _mm_set1_pd(c.center);
+    const __m128d twenty = _mm_set1_pd(20.0);
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d half = _mm_set1_pd(0.5);
+    const __m128d two = _mm_set1_pd(2.0);
+    const __m128d signBit = _mm_set1_pd(-0.0);
+    const __m128i one32 = _mm_set1_epi32(1);
+    const __m128i two32 = _mm_set1_epi32(2);
+    const __m128i four32 = _mm_set1_epi32(4);
+    const __m128i seven32 = _mm_set1_epi32(7);
+
+    int k = 0;
+
+    for (; k + 2 <= count; k += 2) {
+        __m128d x = _mm_mul_pd(_mm_set_pd(k + 1, k), step);
+
+        // Gaussian envelope
+        __m128d d = _mm_sub_pd(x, mu);
+        __m128d t = _mm_div_pd(_mm_sub_pd(zero, _mm_mul_pd(d, d)), twoSigmaSq);
+        __m128d alive = _mm_cmpge_pd(t, _mm_set1_pd(expMinArgument));
+
+        if (_mm_movemask_pd(alive) == 0) {
+            _mm_storeu_pd(output + k, zero);
+            continue;
+        }
+
+        t = _mm_max_pd(t, _mm_set1_pd(expMinArgument));
+
+        __m128i n = _mm_cvtpd_epi32(_mm_mul_pd(t, _mm_set1_pd(M_LOG2E)));
+        __m128d nd = _mm_cvtepi32_pd(n);
+        __m128d r = _mm_sub_pd(_mm_sub_pd(t, _mm_mul_pd(nd, _mm_set1_pd(expC1))), _mm_mul_pd(nd, _mm_set1_pd(expC2)));
+        __m128d rr = _mm_mul_pd(r, r);
+        __m128d px = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(expP[0]), rr), _mm_set1_pd(expP[1]));
+        px = _mm_mul_pd(r, _mm_add_pd(_mm_mul_pd(px, rr), _mm_set1_pd(expP[2])));
+        __m128d qx = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(expQ[0]), rr), _mm_set1_pd(expQ[1]));
+        qx = _mm_add_pd(_mm_mul_pd(qx, rr), _mm_set1_pd(expQ[2]));
+        qx = _mm_add_pd(_mm_mul_pd(qx, rr), _mm_set1_pd(expQ[3]));
+        __m128d e = _mm_add_pd(one, _mm_mul_pd(two, _mm_div_pd(px, _mm_sub_pd(qx, px))));
+        __m128i biased = _mm_unpacklo_epi32(_mm_add_epi32(n, _mm_set1_epi32(1023)), _mm_setzero_si128());
+        e = _mm_mul_pd(e, _mm_castsi128_pd(_mm_slli_epi64(biased, 52)));
+        e = _mm_and_pd(_mm_div_pd(_mm_mul_pd(a, e), norm), alive);
+
+        // chirp
+        __m128d cd = _mm_sub_pd(x, center);
+        __m128d u = _mm_div_pd(_mm_mul_pd(cd, cd), twenty);
+
+        if (_mm_movemask_pd(_mm_cmpgt_pd(u, _mm_set1_pd(cosMaxArgument))) != 0) {
+            formulaScalar(output, k, k + 2, c);
+            continue;
+        }
+
+        __m128i j = _mm_cvttpd_epi32(_mm_mul_pd(u, _mm_set1_pd(cosFourOverPi)));
+        j = _mm_add_epi32(j, _mm_and_si128(j, one32));
+        __m128d y = _mm_cvtepi32_pd(j);
+        j = _mm_and_si128(j, seven32);
+
+        __m128d z = _mm_sub_pd(u, _mm_mul_pd(y, _mm_set1_pd(cosDP1)));
+        z = _mm_sub_pd(z, _mm_mul_pd(y, _mm_set1_pd(cosDP2)));
+        z = _mm_sub_pd(z, _mm_mul_pd(y, _mm_set1_pd(cosDP3)));
+        __m128d zz = _mm_mul_pd(z, z);
+
+        __m128d sp = _mm_set1_pd(sinCoef[0]);
+        __m128d cp = _mm_set1_pd(cosCoef[0]);
+        for (int i = 1; i < 6; ++i) {
+            sp = _mm_add_pd(_mm_mul_pd(sp, zz), _mm_set1_pd(sinCoef[i]));
+            cp = _mm_add_pd(_mm_mul_pd(cp, zz), _mm_set1_pd(cosCoef[i]));
+        }
+        sp = _mm_add_pd(z, _mm_mul_pd(_mm_mul_pd(z, zz), sp));
+        cp = _mm_add_pd(_mm_sub_pd(one, _mm_mul_pd(half, zz)), _mm_mul_pd(_mm_mul_pd(zz, zz), cp));
+
+        __m128i useSin = _mm_cmpeq_epi32(_mm_and_si128(j, two32), two32);
+        __m128i negate = _mm_cmpeq_epi32(_mm_and_si128(_mm_add_epi32(j, two32), four32), four32);
+        __m128d sinMask = _mm_castsi128_pd(_mm_shuffle_epi32(useSin, _MM_SHUFFLE(1, 1, 0, 0)));
+        __m128d negMask = _mm_castsi128_pd(_mm_shuffle_epi32(negate, _MM_SHUFFLE(1, 1, 0, 0)));
+        __m128d cosine = _mm_or_pd(_mm_and_pd(sinMask, sp), _mm_andnot_pd(sinMask, cp));
+        cosine = _mm_xor_pd(cosine, _mm_and_pd(negMask, signBit));
+
+        _mm_storeu_pd(output + k, _mm_mul_pd(e, cosine));
+    }
+
+    formulaScalar(output, k, count, c);
+}
+
+// 4 samples per step
+DSP1_TARGET_AVX2
+void formulaAvx2(double* output, int count, const FormulaConstants& c) {
+    const __m256d step = _mm256_set1_pd(c.step);
+    const __m256d mu = _mm256_set1_pd(c.mu);
+    const __m256d a = _mm256_set1_pd(c.a);
+    const __m256d norm = _mm256_set1_pd(c.norm);
+    const __m256d twoSigmaSq = _mm256_set1_pd(c.twoSigmaSq);
+    const __m256d center = _mm256_set1_pd(c.center);
+    const __m256d twenty = _mm256_set1_pd(20.0);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d two = _mm256_set1_pd(2.0);
+    const __m256d signBit = _mm256_set1_pd(-0.0);
+    const __m256d lanes = _mm256_set_pd(3, 2, 1, 0);
+    const __m128i one32 = _mm_set1_epi32(1);
+    const __m128i two32 = _mm_set1_epi32(2);
+    const __m128i four32 = _mm_set1_epi32(4);
+    const __m128i seven32 = _mm_set1_epi32(7);
+
+    int k = 0;
+
+    for (; k + 4 <= count; k += 4) {
+        __m256d x = _mm256_mul_pd(_mm256_add_pd(_mm256_set1_pd(k), lanes), step);
+
+        // Gaussian envelope
+        __m256d d = _mm256_sub_pd(x, mu);
+        __m256d t = _mm256_div_pd(_mm256_sub_pd(zero, _mm256_mul_pd(d, d)), twoSigmaSq);
+        __m256d alive = _mm256_cmp_pd(t, _mm256_set1_pd(expMinArgument), _CMP_GE_OQ);
+
+        if (_mm256_movemask_pd(alive) == 0) {
+            _mm256_storeu_pd(output + k, zero);
+            continue;
+        }
+
+        t = _mm256_max_pd(t, _mm256_set1_pd(expMinArgument));
+
+        __m128i n = _mm256_cvtpd_epi32(_mm256_mul_pd(t, _mm256_set1_pd(M_LOG2E)));
+        __m256d nd = _mm256_cvtepi32_pd(n);
+        __m256d r = _mm256_sub_pd(_mm256_sub_pd(t, _mm256_mul_pd(nd, _mm256_set1_pd(expC1))),
+                                  _mm256_mul_pd(nd, _mm256_set1_pd(expC2)));
+        __m256d rr = _mm256_mul_pd(r, r);
+        __m256d px = _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(expP[0]), rr), _mm256_set1_pd(expP[1]));
+        px = _mm256_mul_pd(r, _mm256_add_pd(_mm256_mul_pd(px, rr), _mm256_set1_pd(expP[2])));
+        __m256d qx = _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(expQ[0]), rr), _mm256_set1_pd(expQ[1]));
+        qx = _mm256_add_pd(_mm256_mul_pd(qx, rr), _mm256_set1_pd(expQ[2]));
+        qx = _mm256_add_pd(_mm256_mul_pd(qx, rr), _mm256_set1_pd(expQ[3]));
+        __m256d e = _mm256_add_pd(one, _mm256_mul_pd(two, _mm256_div_pd(px, _mm256_sub_pd(qx, px))));
+        __m256i biased = _mm256_cvtepi32_epi64(_mm_add_epi32(n, _mm_set1_epi32(1023)));
+        e = _mm256_mul_pd(e, _mm256_castsi256_pd(_mm256_slli_epi64(biased, 52)));
+        e = _mm256_and_pd(_mm256_div_pd(_mm256_mul_pd(a, e), norm), alive);
+
+        // chirp
+        __m256d cd = _mm256_sub_pd(x, center);
+        __m256d u = _mm256_div_pd(_mm256_mul_pd(cd, cd), twenty);
+
+        if (_mm256_movemask_pd(_mm256_cmp_pd(u, _mm256_set1_pd(cosMaxArgument), _CMP_GT_OQ)) != 0) {
+            formulaScalar(output, k, k + 4, c);
+            continue;
+        }
+
+        __m128i j = _mm256_cvttpd_epi32(_mm256_mul_pd(u, _mm256_set1_pd(cosFourOverPi)));
+        j = _mm_add_epi32(j, _mm_and_si128(j, one32));
+        __m256d y = _mm256_cvtepi32_pd(j);
+        j = _mm_and_si128(j, seven32);
+
+        __m256d z = _mm256_sub_pd(u, _mm256_mul_pd(y, _mm256_set1_pd(cosDP1)));
+        z = _mm256_sub_pd(z, _mm256_mul_pd(y, _mm256_set1_pd(cosDP2)));
+        z = _mm256_sub_pd(z, _mm256_mul_pd(y, _mm256_set1_pd(cosDP3)));
+        __m256d zz = _mm256_mul_pd(z, z);
+
+        __m256d sp = _mm256_set1_pd(sinCoef[0]);
+        __m256d cp = _mm256_set1_pd(cosCoef[0]);
+        for (int i = 1; i < 6; ++i) {
+            sp = _mm256_add_pd(_mm256_mul_pd(sp, zz), _mm256_set1_pd(sinCoef[i]));
+            cp = _mm256_add_pd(_mm256_mul_pd(cp, zz), _mm256_set1_pd(cosCoef[i]));
+        }
+        sp = _mm256_add_pd(z, _mm256_mul_pd(_mm256_mul_pd(z, zz), sp));
+        cp = _mm256_add_pd(_mm256_sub_pd(one, _mm256_mul_pd(half, zz)), _mm256_mul_pd(_mm256_mul_pd(zz, zz), cp));
+
+        __m128i useSin = _mm_cmpeq_epi32(_mm_and_si128(j, two32), two32);
+        __m128i negate = _mm_cmpeq_epi32(_mm_and_si128(_mm_add_epi32(j, two32), four32), four32);
+        __m256d sinMask = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(useSin));
+        __m256d negMask = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(negate));
+        __m256d cosine = _mm256_blendv_pd(cp, sp, sinMask);
+        cosine = _mm256_xor_pd(cosine, _mm256_and_pd(negMask, signBit));
+
+        _mm256_storeu_pd(output + k, _mm256_mul_pd(e, cosine));
+    }
+
+    formulaScalar(output, k, count, c);
+}
+
+bool cpuHasAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+
+    // AVX registers must also be enabled by the OS
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!osxsave || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#else
+
+void formulaDefault(double* output, int count, const FormulaConstants& c) {
+    formulaScalar(output, 0, count, c);
+}
+
+#endif // DSP1_X86_SIMD
+
+typedef void (*FormulaKernel)(double*, int, const FormulaConstants&);
+
+FormulaKernel selectFormulaKernel() {
+#ifdef DSP1_X86_SIMD
+    if (cpuHasAvx2()) {
+        return formulaAvx2;
+    }
+
+    return formulaSse2;
+#else
+    return formulaDefault;
+#endif
+}
+
+// a thread is only worth starting for this many samples
+const long long noiseMinChunk = 1 << 15;
+
+// Standard normal limited to [a, b], Robert's mixed rejection algorithm.
+// Every branch accepts with a probability bounded away from zero.
+double truncatedStandardNormal(RandomStream& stream, double a, double b) {
+    if (b <= 0) {
+        return -truncatedStandardNormal(stream, -b, -a);
+    }
+
+    if (a < 0) {
+        // the interval holds the mode, wide ones are sampled from the plain normal
+        if (b - a >= sqrt(2 * M_PI)) {
+            for (;;) {
+                double z = stream.nextNormal();
+
+                if (z >= a && z <= b) {
+                    return z;
+                }
+            }
+        }
+
+        for (;;) {
+            double z = a + (b - a) * stream.nextUniform();
+
+            if (stream.nextUniform() <= exp(-z*z / 2)) {
+                return z;
+            }
+        }
+    }
+
+    // one-sided interval [a, b] with a >= 0
+    if ((b - a) * (b + a) <= 2) {
+        for (;;) {
+            double z = a + (b - a) * stream.nextUniform();
+
+            if (stream.nextUniform() <= exp((a*a - z*z) / 2)) {
+                return z;
+            }
+        }
+    }
+
+    // translated exponential proposal with the optimal rate
+    double alpha = (a + sqrt(a*a + 4)) / 2;
+
+    for (;;) {
+        double z = a - log(stream.nextUniform()) / alpha;
+
+        if (z <= b && stream.nextUniform() <= exp(-(z - alpha)*(z - alpha) / 2)) {
+            return z;
+        }
+    }
+}
+
+double noiseSample(RandomStream& stream, double mean, double sd, double lowBoundary, double highBoundary,
+                   NoiseSampling sampling) {
+    if (!(sd > 0) || !(lowBoundary < highBoundary)) {
+        return std::min(std::max(mean, lowBoundary), highBoundary);
+    }
+
+    if (sampling == TruncatedSampling) {
+        double z = truncatedStandardNormal(stream, (lowBoundary - mean) / sd, (highBoundary - mean) / sd);
+
+        // rounding in the back transform must not leave the boundaries
+        return std::min(std::max(mean + sd * z, lowBoundary), highBoundary);
+    }
+
+    for (;;) {
+        double number = mean + sd * stream.nextNormal();
+
+        if (number >= lowBoundary && number <= highBoundary) {
+            return number;
+        }
+    }
+}
+
+} // namespace
+
+void generateFormula(double* output, int count, double step, double a, double sigma, double mu) {
+    static const FormulaKernel kernel = selectFormulaKernel();
+
+    FormulaConstants constants;
+    constants.step = step;
+    constants.mu = mu;
+    constants.a = a;
+    constants.norm = sigma*sqrt(2*M_PI);
+    constants.twoSigmaSq = 2*sigma*sigma;
+    constants.center = count*step/2;
+
+    kernel(output, count, constants);
+}
+
+void generateNoise(double* output, int count, double mean, double sd,
+                   double lowBoundary, double highBoundary, quint64 seed,
+                   NoiseSampling sampling) {
+    int chunks = parallelChunkCount(count, noiseMinChunk);
+
+    parallelChunks(count, chunks, [=](int, long long begin, long long end) {
+        for (long long i = begin; i < end; ++i) {
+            RandomStream stream(seed, i);
+            output[i] = noiseSample(stream, mean, sd, lowBoundary, highBoundary, sampling);
+        }
+    });
+}
@@ -0,0 +1,109 @@
+#include "signalio.h"
+#include "constants.h"
+
+#include <QFile>
+#include <algorithm>
+#include <cstdio>
+
+#if (__cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)) && defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+
+namespace {
+
+// Accumulates text in a fixed buffer and hands it to the file in large blocks
+class BufferedWriter
+{
+    public:
+        explicit BufferedWriter(QFile& file) : file(file), used(0), failed(false) {
+        }
+
+        ~BufferedWriter() {
+            flush();
+        }
+
+        void write(const char* text, int size) {
+            if (used + size > bufferSize) {
+                flush();
+            }
+
+            if (size > bufferSize) {
+                failed = failed || file.write(text, size) != size;
+                return;
+            }
+
+            std::copy(text, text + size, buffer + used);
+            used += size;
+        }
+
+        void write(const QString& text) {
+            QByteArray bytes = text.toUtf8();
+            write(bytes.constData(), bytes.size());
+        }
+
+        void write(char c) {
+            write(&c, 1);
+        }
+
+        // same text as QString::number(value), i.e. %g with 6 significant digits
+        void write(double value) {
+            char text[32];
+#if defined(__cpp_lib_to_chars)
+            int size = std::to_chars(text, text + sizeof(text), value, std::chars_format::general, 6).ptr - text;
+#else
+            int size = std::snprintf(text, sizeof(text), "%g", value);
+#endif
+            write(text, size);
+        }
+
+        bool flush() {
+            if (used > 0 && file.write(buffer, used) != used) {
+                failed = true;
+            }
+            used = 0;
+
+            return !failed;
+        }
+
+    private:
+        static const int bufferSize = 64 * 1024;
+
+        QFile& file;
+        char buffer[bufferSize];
+        int used;
+        bool failed;
+};
+
+} // namespace
+
+bool writeProbabilityTable(const Signal& signal, const QString& fileName) {
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    const QVector<double>& bins = signal.getHistogramXAxis();
+    const QVector<double>& probability = signal.getProbability();
+    int rows = std::min(bins.size(), probability.size());
+
+    BufferedWriter output(file);
+
+    for (const QString& header : tableProbabilityHeaders) {
+        output.write(header);
+        output.write(' ');
+    }
+    output.write('\n');
+
+    for (int i = 0; i < rows; ++i) {
+        output.write(bins[i]);
+        output.write(' ');
+        output.write(probability[i]);
+        output.write(' ');
+        output.write('\n');
+    }
+
+    return output.flush();
+}
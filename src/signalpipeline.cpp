@@ -0,0 +1,243 @@
+#include "signalpipeline.h"
+#include "constants.h"
+
+#include <QtConcurrent>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Stage tags keep equal parameter lists of different stages apart
+enum PipelineStage {
+    FormulaStage = 1,
+    NoiseStage,
+    SumStage,
+    ConvolutionStage,
+    HistogramStage,
+    HistogramConvolutionStage
+};
+
+quint64 hashCombine(quint64 key, quint64 value) {
+    key ^= value + 0x9e3779b97f4a7c15ULL + (key << 6) + (key >> 2);
+    key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+    return key ^ (key >> 31);
+}
+
+quint64 hashCombine(quint64 key, double value) {
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return hashCombine(key, bits);
+}
+
+quint64 hashCombine(quint64 key, int value) {
+    return hashCombine(key, static_cast<quint64>(value));
+}
+
+} // namespace
+
+PipelineCache::PipelineCache(int maxCost) :
+    results(maxCost)
+{
+}
+
+bool PipelineCache::find(quint64 key, Signal& result) {
+    QMutexLocker locker(&mutex);
+    Signal* cached = results.object(key);
+
+    if (cached) {
+        result = *cached;
+    }
+
+    return cached != 0;
+}
+
+void PipelineCache::insert(quint64 key, const Signal& result, int cost) {
+    QMutexLocker locker(&mutex);
+    results.insert(key, new Signal(result), std::max(cost, 1));
+}
+
+void PipelineCache::clear() {
+    QMutexLocker locker(&mutex);
+    results.clear();
+}
+
+SignalPipeline::SignalPipeline(QObject *parent) :
+    QObject(parent),
+    cancelRequested(0),
+    cache(pipelineCacheSamples)
+{
+    qRegisterMetaType<SignalMap>("SignalMap");
+}
+
+SignalPipeline::~SignalPipeline()
+{
+    cancel();
+    wait();
+}
+
+bool SignalPipeline::start(const PipelineParameters& parameters) {
+    if (isRunning()) {
+        return false;
+    }
+
+    cancelRequested.storeRelease(0);
+    future = QtConcurrent::run([this, parameters]() {
+        run(parameters);
+    });
+
+    return true;
+}
+
+void SignalPipeline::cancel() {
+    cancelRequested.storeRelease(1);
+}
+
+void SignalPipeline::wait() {
+    future.waitForFinished();
+}
+
+bool SignalPipeline::isRunning() const {
+    return future.isRunning();
+}
+
+void SignalPipeline::run(const PipelineParameters& parameters) {
+    SignalMap data = compute(parameters, cancelRequested, [this](int percent, const QString& stage) {
+        emit progressChanged(percent, stage);
+    }, &cache);
+
+    if (data.isEmpty()) {
+        emit canceled();
+    }
+    else {
+        emit finished(data);
+    }
+}
+
+SignalMap SignalPipeline::compute(const PipelineParameters& parameters, const QAtomicInt& canceled,
+                                  const ProgressCallback& progress, PipelineCache* cache) {
+    SignalMap data;
+
+    auto stage = [&](int percent, const QString& name) -> bool {
+        if (canceled.loadAcquire()) {
+            return false;
+        }
+        if (progress) {
+            progress(percent, name);
+        }
+
+        return true;
+    };
+
+    // returns the cached result of key or builds and remembers it
+    auto evaluate = [cache](quint64 key, const std::function<int(Signal&)>& build) -> Signal {
+        Signal result;
+
+        if (cache && cache->find(key, result)) {
+            return result;
+        }
+
+        int cost = build(result);
+
+        if (cache) {
+            cache->insert(key, result, cost);
+        }
+
+        return result;
+    };
+
+    auto histogram = [&](quint64 key, const Signal& source) -> Signal {
+        quint64 histogramKey = hashCombine(hashCombine(quint64(HistogramStage), key), parameters.histogramBins);
+
+        // samples are shared with the source, only the bins count against the cache
+        return evaluate(histogramKey, [&](Signal& result) {
+            result = source;
+            result.setHistogram(parameters.histogramBins);
+            return result.getHistogramYAxis().size();
+        });
+    };
+
+    quint64 signalKey = quint64(FormulaStage);
+    signalKey = hashCombine(signalKey, parameters.signalCount);
+    signalKey = hashCombine(signalKey, parameters.signalStep);
+    signalKey = hashCombine(signalKey, parameters.signalA);
+    signalKey = hashCombine(signalKey, parameters.signalSigma);
+    signalKey = hashCombine(signalKey, parameters.signalMu);
+
+    // noise boundaries come from the signal
+    quint64 noiseKey = hashCombine(quint64(NoiseStage), signalKey);
+    noiseKey = hashCombine(noiseKey, parameters.noiseCount);
+    noiseKey = hashCombine(noiseKey, parameters.noiseMean);
+    noiseKey = hashCombine(noiseKey, parameters.noiseSD);
+    noiseKey = hashCombine(noiseKey, parameters.noiseSeed);
+
+    quint64 sumKey = hashCombine(hashCombine(quint64(SumStage), signalKey), noiseKey);
+    quint64 convolutionKey = hashCombine(hashCombine(quint64(ConvolutionStage), signalKey), noiseKey);
+
+    if (!stage(0, signalLabel)) {
+        return SignalMap();
+    }
+
+    Signal signal = evaluate(signalKey, [&](Signal& result) {
+        result.setByFormula(parameters.signalCount, parameters.signalStep, parameters.signalA,
+                            parameters.signalSigma, parameters.signalMu);
+        return static_cast<int>(result.getSize());
+    });
+
+    if (!stage(20, noiseLabel)) {
+        return SignalMap();
+    }
+
+    Signal noise = evaluate(noiseKey, [&](Signal& result) {
+        result.setSeed(parameters.noiseSeed);
+        result.setByNoise(parameters.noiseCount, parameters.noiseMean, parameters.noiseSD,
+                          signal.getMin(), signal.getMax());
+        return static_cast<int>(result.getSize());
+    });
+
+    if (!stage(40, sumLabel)) {
+        return SignalMap();
+    }
+
+    Signal sum = evaluate(sumKey, [&](Signal& result) {
+        result.setBySum({signal.getView(), noise.getView()});
+        return static_cast<int>(result.getSize());
+    });
+
+    if (!stage(50, convolutionLabel)) {
+        return SignalMap();
+    }
+
+    data[convolutionLabel] = evaluate(convolutionKey, [&](Signal& result) {
+        result.setByConvolution(signal, noise);
+        return static_cast<int>(result.getSize());
+    });
+
+    if (!stage(90, tabHistogramTitle)) {
+        return SignalMap();
+    }
+
+    // histograms back the probability tables
+    data[signalLabel] = histogram(signalKey, signal);
+    data[noiseLabel] = histogram(noiseKey, noise);
+    data[sumLabel] = histogram(sumKey, sum);
+
+    // the Convolution choice of the histogram tab
+    quint64 histogramConvolutionKey = hashCombine(hashCombine(hashCombine(quint64(HistogramConvolutionStage),
+                                                                          signalKey), noiseKey),
+                                                  parameters.histogramBins);
+
+    data[histogramConvolutionLabel] = evaluate(histogramConvolutionKey, [&](Signal& result) {
+        Signal noiseHistogram = data[noiseLabel];
+
+        result = data[signalLabel];
+        result.convolveHistograms(noiseHistogram, parameters.histogramBins);
+        return result.getHistogramYAxis().size();
+    });
+
+    if (!stage(100, QString())) {
+        return SignalMap();
+    }
+
+    return data;
+}
@@ -0,0 +1,212 @@
+#include "statistics.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+namespace {
+
+// samples handled per block, the block is read twice while it stays in L1 cache
+const int statisticsBlockSize = 512;
+// independent accumulators per sum, lets the compiler keep them in one vector register
+const int statisticsLanes = 4;
+// a thread is only worth starting for this many samples
+const long long statisticsMinChunk = 1 << 16;
+
+// Exact moments of one block: the mean first, then the central sums around it.
+// Narrow samples are widened lane by lane, which the compiler turns into vector conversions.
+template<typename T>
+MomentAccumulator blockMoments(const T* data, int size) {
+    double sum[statisticsLanes] = {};
+    double low[statisticsLanes];
+    double high[statisticsLanes];
+    std::fill(low, low + statisticsLanes, std::numeric_limits<double>::infinity());
+    std::fill(high, high + statisticsLanes, -std::numeric_limits<double>::infinity());
+
+    int vectorSize = size - size % statisticsLanes;
+
+    for (int i = 0; i < vectorSize; i += statisticsLanes) {
+        for (int lane = 0; lane < statisticsLanes; ++lane) {
+            double x = static_cast<double>(data[i + lane]);
+            sum[lane] += x;
+            low[lane] = std::min(low[lane], x);
+            high[lane] = std::max(high[lane], x);
+        }
+    }
+    for (int i = vectorSize; i < size; ++i) {
+        double x = static_cast<double>(data[i]);
+        sum[0] += x;
+        low[0] = std::min(low[0], x);
+        high[0] = std::max(high[0], x);
+    }
+
+    MomentAccumulator block;
+    block.count = size;
+    block.mean = (sum[0] + sum[1] + sum[2] + sum[3]) / size;
+    block.min = *std::min_element(low, low + statisticsLanes);
+    block.max = *std::max_element(high, high + statisticsLanes);
+
+    double m2[statisticsLanes] = {};
+    double m3[statisticsLanes] = {};
+    double m4[statisticsLanes] = {};
+
+    for (int i = 0; i < vectorSize; i += statisticsLanes) {
+        for (int lane = 0; lane < statisticsLanes; ++lane) {
+            double d = data[i + lane] - block.mean;
+            double d2 = d * d;
+            m2[lane] += d2;
+            m3[lane] += d2 * d;
+            m4[lane] += d2 * d2;
+        }
+    }
+    for (int i = vectorSize; i < size; ++i) {
+        double d = data[i] - block.mean;
+        double d2 = d * d;
+        m2[0] += d2;
+        m3[0] += d2 * d;
+        m4[0] += d2 * d2;
+    }
+
+    block.m2 = m2[0] + m2[1] + m2[2] + m2[3];
+    block.m3 = m3[0] + m3[1] + m3[2] + m3[3];
+    block.m4 = m4[0] + m4[1] + m4[2] + m4[3];
+
+    return block;
+}
+
+template<typename T>
+MomentAccumulator chunkMoments(const T* data, long long size, const HistogramLayout* layout, qint64* counts) {
+    MomentAccumulator total;
+
+    for (long long first = 0; first < size; first += statisticsBlockSize) {
+        int blockSize = static_cast<int>(std::min<long long>(statisticsBlockSize, size - first));
+
+        total.merge(blockMoments<T>(data + first, blockSize));
+
+        if (layout) {
+            histogramAccumulate(data + first, blockSize, *layout, counts);
+        }
+    }
+
+    return total;
+}
+
+template<typename T>
+SignalStatistics statisticsPass(const T* data, long long size, const HistogramLayout* layout, qint64* counts) {
+    int chunks = parallelChunkCount(size, statisticsMinChunk);
+    int bins = layout ? layout->size : 0;
+
+    if (chunks == 1) {
+        return chunkMoments(data, size, layout, counts).statistics();
+    }
+
+    std::vector<MomentAccumulator> partial(chunks);
+    std::vector<QVector<qint64>> partialCounts(chunks);
+
+    parallelChunks(size, chunks, [&](int chunk, long long begin, long long end) {
+        partialCounts[chunk].fill(0, bins);
+        partial[chunk] = chunkMoments(data + begin, end - begin, layout, partialCounts[chunk].data());
+    });
+
+    MomentAccumulator total;
+
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        total.merge(partial[chunk]);
+
+        for (int i = 0; i < bins; ++i) {
+            counts[i] += partialCounts[chunk][i];
+        }
+    }
+
+    return total.statistics();
+}
+
+} // namespace
+
+MomentAccumulator::MomentAccumulator() :
+    count(0), mean(0), m2(0), m3(0), m4(0),
+    min(std::numeric_limits<double>::infinity()), max(-std::numeric_limits<double>::infinity()) {
+}
+
+void MomentAccumulator::merge(const MomentAccumulator& other) {
+    if (other.count == 0) {
+        return;
+    }
+    if (count == 0) {
+        *this = other;
+        return;
+    }
+
+    double na = count;
+    double nb = other.count;
+    double n = na + nb;
+    double delta = other.mean - mean;
+    double delta2 = delta * delta;
+
+    double mergedM2 = m2 + other.m2 + delta2 * na * nb / n;
+    double mergedM3 = m3 + other.m3 + delta2 * delta * na * nb * (na - nb) / (n * n)
+                    + 3 * delta * (na * other.m2 - nb * m2) / n;
+    double mergedM4 = m4 + other.m4 + delta2 * delta2 * na * nb * (na*na - na*nb + nb*nb) / (n * n * n)
+                    + 6 * delta2 * (na*na * other.m2 + nb*nb * m2) / (n * n)
+                    + 4 * delta * (na * other.m3 - nb * m3) / n;
+
+    count += other.count;
+    mean += delta * nb / n;
+    m2 = mergedM2;
+    m3 = mergedM3;
+    m4 = mergedM4;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+}
+
+SignalStatistics MomentAccumulator::statistics() const {
+    SignalStatistics result;
+    result.count = count;
+
+    if (count == 0) {
+        result.min = result.max = result.mean = 0;
+        result.variance = result.skewness = result.kurtosis = 0;
+        return result;
+    }
+
+    double n = count;
+
+    result.min = min;
+    result.max = max;
+    result.mean = mean;
+    result.variance = count > 1 ? m2 / (n - 1) : 0;
+    result.skewness = m2 > 0 ? sqrt(n) * m3 / pow(m2, 1.5) : 0;
+    result.kurtosis = m2 > 0 ? n * m4 / (m2 * m2) - 3 : 0;
+
+    return result;
+}
+
+template<typename T>
+SignalStatistics computeStatistics(const T* data, long long size) {
+    return statisticsPass<T>(data, size, 0, 0);
+}
+
+template<typename T>
+SignalStatistics computeStatistics(const T* data, long long size,
+                                   const HistogramLayout& layout, QVector<qint64>& counts) {
+    counts.fill(0, layout.size);
+
+    return statisticsPass(data, size, &layout, counts.data());
+}
+
+template<typename T>
+void accumulateMoments(const T* data, long long size, MomentAccumulator& accumulator,
+                       const HistogramLayout* layout, qint64* counts) {
+    accumulator.merge(chunkMoments(data, size, layout, counts));
+}
+
+template SignalStatistics computeStatistics(const double*, long long);
+template SignalStatistics computeStatistics(const float*, long long);
+template SignalStatistics computeStatistics(const qint16*, long long);
+template SignalStatistics computeStatistics(const double*, long long, const HistogramLayout&, QVector<qint64>&);
+template SignalStatistics computeStatistics(const float*, long long, const HistogramLayout&, QVector<qint64>&);
+template SignalStatistics computeStatistics(const qint16*, long long, const HistogramLayout&, QVector<qint64>&);
+template void accumulateMoments(const double*, long long, MomentAccumulator&, const HistogramLayout*, qint64*);
+template void accumulateMoments(const float*, long long, MomentAccumulator&, const HistogramLayout*, qint64*);
+template void accumulateMoments(const qint16*, long long, MomentAccumulator&, const HistogramLayout*, qint64*);
@@ -0,0 +1,116 @@
+#include "streamconvolver.h"
+
+#include <algorithm>
+
+StreamConvolver::StreamConvolver(const QVector<double>& kernel, int blockSize) :
+    kernelSize(std::max(1, kernel.size())), blockSize(blockSize), pendingSize(0) {
+
+    // by default each transform is about four times longer than the kernel,
+    // which keeps the per-sample cost close to the optimum of overlap-add
+    if (this->blockSize <= 0) {
+        transformSize = fftLength(std::max(256, 4 * kernelSize));
+        this->blockSize = transformSize - kernelSize + 1;
+    }
+    else {
+        transformSize = fftLength(this->blockSize + kernelSize - 1);
+    }
+
+    kernelSpectrum.resize(transformSize);
+
+    for (int i = 0; i < kernel.size(); ++i) {
+        kernelSpectrum[i] = kernel[i];
+    }
+
+    fft(kernelSpectrum);
+
+    workspace.resize(transformSize);
+    pending.resize(this->blockSize);
+    overlap.resize(kernelSize - 1);
+}
+
+void StreamConvolver::reset() {
+    pendingSize = 0;
+    std::fill(overlap.begin(), overlap.end(), 0.0);
+}
+
+int StreamConvolver::getBlockSize() const {
+    return blockSize;
+}
+
+int StreamConvolver::getKernelSize() const {
+    return kernelSize;
+}
+
+QVector<double> StreamConvolver::process(const QVector<double>& chunk) {
+    return process(chunk.constData(), chunk.size());
+}
+
+QVector<double> StreamConvolver::process(const double* chunk, int size) {
+    QVector<double> output;
+    output.reserve((pendingSize + size) / blockSize * blockSize);
+
+    while (size > 0) {
+        int taken = std::min(size, blockSize - pendingSize);
+
+        std::copy(chunk, chunk + taken, pending.begin() + pendingSize);
+        pendingSize += taken;
+        chunk += taken;
+        size -= taken;
+
+        if (pendingSize == blockSize) {
+            convolveBlock(blockSize, output);
+            pendingSize = 0;
+        }
+    }
+
+    return output;
+}
+
+QVector<double> StreamConvolver::flush() {
+    QVector<double> output;
+
+    if (pendingSize > 0) {
+        convolveBlock(pendingSize, output);
+        pendingSize = 0;
+    }
+
+    // the last block's tail only contains the kernel overhang
+    output += overlap;
+    std::fill(overlap.begin(), overlap.end(), 0.0);
+
+    return output;
+}
+
+void StreamConvolver::convolveBlock(int size, QVector<double>& output) {
+    for (int i = 0; i < size; ++i) {
+        workspace[i] = pending[i];
+    }
+    std::fill(workspace.begin() + size, workspace.end(), Complex());
+
+    fft(workspace);
+
+    for (int k = 0; k < transformSize; ++k) {
+        workspace[k] *= kernelSpectrum[k];
+    }
+
+    fft(workspace, true);
+
+    int tail = kernelSize - 1;
+
+    // samples [0, size) are final once the previous tail is added
+    for (int i = 0; i < size; ++i) {
+        double value = workspace[i].real();
+
+        if (i < tail) {
+            value += overlap[i];
+        }
+
+        output.push_back(value);
+    }
+
+    // the new tail overlaps the next block
+    for (int i = 0; i < tail; ++i) {
+        double carried = (size + i < tail) ? overlap[size + i] : 0;
+        overlap[i] = workspace[size + i].real() + carried;
+    }
+}